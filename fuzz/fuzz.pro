@@ -0,0 +1,21 @@
+TEMPLATE = app
+CONFIG += qt console
+CONFIG -= app_bundle
+QT = core gui
+TARGET = fuzz_blackmilord
+
+LIBS += -lblackmilord
+
+include(../project.pri)
+
+#libFuzzer provides main(), build with clang: qmake -spec linux-clang
+QMAKE_CXXFLAGS += -fsanitize=fuzzer,address,undefined
+QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+
+OBJECTS_DIR = $$BLACK_MILORD_BUILD_ROOT/build/$$DESTPREFIX/fuzz
+MOC_DIR = $$BLACK_MILORD_BUILD_ROOT/build/$$DESTPREFIX/fuzz
+
+#the text reader needs the whole book model
+include(../src/src.pri)
+
+SOURCES += main_fuzz.cpp
@@ -0,0 +1,131 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include <QByteArray>
+#include <QBuffer>
+#include <QDataStream>
+#include <QTemporaryFile>
+#include <QtGlobal>
+#include <cstdlib>
+
+#include <DatabaseHeader.h>
+#include <PalmDOCHeader.h>
+#include <MOBIHeader.h>
+#include <EXTHHeader.h>
+#include <MobiCodec.h>
+#include <AbstractBook.h>
+
+/*
+ * libFuzzer entry points. Every input is given to the parsers of untrusted data:
+ * database header of the whole file, headers of the first record, PalmDOC decoder
+ * and decoding of the whole text. Encoded input must decode back to itself.
+ * Checks call abort() as Q_ASSERT is removed from release builds.
+ * Run: fuzz_blackmilord -max_len=65536 CORPUS_DIRECTORY sample
+ */
+
+namespace {
+    //parsers print what they read, it would only slow fuzzing down
+    void ignoreMessage(QtMsgType, const char *)
+    {
+    }
+
+    //the text reader opens files by name, so every input is written to this file
+    QTemporaryFile *textFile = NULL;
+
+    void fuzzDatabaseHeader(const QByteArray &input)
+    {
+        QBuffer buffer;
+        buffer.setData(input);
+        buffer.open(QIODevice::ReadOnly);
+        QDataStream data(&buffer);
+        DatabaseHeader header;
+        if (header.read(data)) {
+            for (int i = 0; i < header.getNumberOfRecords(); ++i) {
+                if (header.getRecordOffset(i) + header.getRecordLength(i) > static_cast<quint32>(input.size())) {
+                    abort();
+                }
+            }
+        }
+    }
+
+    void fuzzHeaderRecord(const QByteArray &input)
+    {
+        QBuffer buffer;
+        buffer.setData(input);
+        buffer.open(QIODevice::ReadOnly);
+        QDataStream data(&buffer);
+        PalmDOCHeader palmDOCHeader;
+        MOBIHeader mobiHeader;
+        EXTHHeader exthHeader;
+        if (palmDOCHeader.read(data) && mobiHeader.read(data)) {
+            exthHeader.read(data);
+        }
+    }
+
+    void fuzzDecoder(const QByteArray &input)
+    {
+        QByteArray result;
+        MobiCodec::DecodePalmDoc(input, result);
+    }
+
+    void fuzzEncoder(const QByteArray &input)
+    {
+        QByteArray compressed;
+        MobiCodec::EncodePalmDoc(input, compressed);
+        QByteArray result;
+        if (!MobiCodec::DecodePalmDoc(compressed, result) || result != input) {
+            abort();
+        }
+    }
+
+    void fuzzReadText(const QByteArray &input)
+    {
+        if (!textFile->resize(0) || !textFile->seek(0) ||
+            textFile->write(input) != input.size() || !textFile->flush())
+        {
+            abort();
+        }
+        QString text;
+        QString why;
+        AbstractBookFactory::getObject()->readText(textFile->fileName(), text, why);
+    }
+}
+
+extern "C" int LLVMFuzzerInitialize(int *, char ***)
+{
+    qInstallMsgHandler(ignoreMessage);
+    textFile = new QTemporaryFile();
+    if (!textFile->open()) {
+        abort();
+    }
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const quint8 *data, size_t size)
+{
+    const QByteArray input = QByteArray::fromRawData(reinterpret_cast<const char*>(data), size);
+    fuzzDatabaseHeader(input);
+    fuzzHeaderRecord(input);
+    fuzzDecoder(input);
+    fuzzEncoder(input);
+    fuzzReadText(input);
+    return 0;
+}
@@ -5,5 +5,8 @@ include(project.pri)
 
 SUBDIRS += src/interface
 SUBDIRS += src
+SUBDIRS += src/cli
 SUBDIRS += src/plugins
-#SUBDIRS += test
\ No newline at end of file
+#SUBDIRS += test
+#libFuzzer harness of the file parsers, needs clang
+#SUBDIRS += fuzz
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include <QSharedPointer>
 
 class QString;
+struct BookMetadata;
 
 class AbstractBook
 {
@@ -42,6 +43,18 @@ public:
     virtual bool newFile() = 0;
     virtual bool canOpenFile() = 0;
     virtual bool canSaveFile() = 0;
+
+    /**
+     * Reads only metadata and cover of the file, text is not decoded.
+     * Does not use Book, so it may be called from any thread.
+     */
+    virtual bool readMetadata(const QString &fileName, BookMetadata &metadata) = 0;
+
+    /**
+     * Decodes the whole text of the file without touching Book and pictures,
+     * so files may be checked in parallel.
+     */
+    virtual bool readText(const QString &fileName, QString &text, QString &why) = 0;
 };
 
 typedef QSharedPointer<AbstractBook> AbstractBookPtr;
@@ -30,12 +30,14 @@
 #include <PlainTextEditor.h>
 #include <StatusBar.h>
 #include <Preferences.h>
+#include <Spellcheck.h>
 #include <XMLElement.h>
+#include <Formatting.h>
+#include <ImageOptimizer.h>
+#include <DeviceConfiguration.h>
 #include "AbstractBook.h"
 #include "BackupManager.h"
 
-//TODO: emit textChanged when text changes
-
 Book::Book()
 {
     reset();
@@ -58,9 +60,17 @@ bool Book::openFile(const QString &fileName)
     if (result) {
         m_fileName = fileName;
         m_fileOpened = true;
-        Gui::statusBar()->showMessage(tr("Document imported from") + " " + fileName);
+        if (Gui::hasStatusBar()) {
+            Gui::statusBar()->showMessage(tr("Document imported from") + " " + fileName);
+        }
         emit fileLoaded();
     }
+    else {
+        //pictures are added before the text is decoded, drop them but keep the reason
+        const QString why = m_why;
+        reset();
+        m_why = why;
+    }
     return result;
 }
 
@@ -77,7 +87,9 @@ bool Book::saveFile()
     }
     bool result = AbstractBookFactory::getObject()->saveFile(m_fileName);
     if (result) {
-        Gui::statusBar()->showMessage(tr("Document is saved"));
+        if (Gui::hasStatusBar()) {
+            Gui::statusBar()->showMessage(tr("Document is saved"));
+        }
         emit fileSaved();
     }
     return result;
@@ -97,7 +109,9 @@ bool Book::newFile()
     bool result = AbstractBookFactory::getObject()->newFile();
     if (result) {
         m_fileOpened = true;
-        Gui::statusBar()->showMessage(tr("New document is created"));
+        if (Gui::hasStatusBar()) {
+            Gui::statusBar()->showMessage(tr("New document is created"));
+        }
         emit fileCreated();
     }
     return result;
@@ -108,16 +122,22 @@ void Book::reset()
     m_fileOpened = false;
 
     m_pictures.clear();
+    m_pictureHashes.clear();
     m_author.clear();
     m_publisher.clear();
     m_description.clear();
     m_isbn.clear();
     m_subject.clear();
+    m_language.clear();
+    Spellcheck::instance().setDocumentLanguage(m_language);
     m_version = 0;
     m_creationDate = QDateTime();
     m_modificationDate = QDateTime();
     m_lastBackupDate = QDateTime();
     m_modificationNumber = 0;
+    m_exthRecords.clear();
+    m_coverPicture = -1;
+    m_thumbnailPicture = -1;
 
     m_fileName.clear();
     m_why.clear();
@@ -144,6 +164,8 @@ QVariant Book::getMetadata(MetaData metadata) const
         return m_isbn;
     case METADATA_SUBJECT:
         return m_subject;
+    case METADATA_LANGUAGE:
+        return m_language;
     case METADATA_VERSION:
         return m_version;
     case METADATA_CREATION_DATE:
@@ -154,6 +176,12 @@ QVariant Book::getMetadata(MetaData metadata) const
         return m_lastBackupDate;
     case METADATA_MODIFICATION_NUMBER:
         return m_modificationNumber;
+    case METADATA_EXTH_RECORDS:
+        return m_exthRecords;
+    case METADATA_COVER_PICTURE:
+        return m_coverPicture;
+    case METADATA_THUMBNAIL_PICTURE:
+        return m_thumbnailPicture;
     default:
         break;
     }
@@ -180,6 +208,10 @@ void Book::setMetadata(MetaData metadata, const QVariant &data)
     case METADATA_SUBJECT:
         m_subject = data.toString();
         break;
+    case METADATA_LANGUAGE:
+        m_language = data.toString();
+        Spellcheck::instance().setDocumentLanguage(m_language);
+        break;
     case METADATA_VERSION:
         m_version = data.toUInt();
         break;
@@ -195,6 +227,15 @@ void Book::setMetadata(MetaData metadata, const QVariant &data)
     case METADATA_MODIFICATION_NUMBER:
         m_modificationNumber = data.toUInt();
         break;
+    case METADATA_EXTH_RECORDS:
+        m_exthRecords = data.toByteArray();
+        break;
+    case METADATA_COVER_PICTURE:
+        m_coverPicture = data.toInt();
+        break;
+    case METADATA_THUMBNAIL_PICTURE:
+        m_thumbnailPicture = data.toInt();
+        break;
     default:
         Q_ASSERT(false);
     }
@@ -203,12 +244,70 @@ void Book::setMetadata(MetaData metadata, const QVariant &data)
 
 QString Book::getText() const
 {
-    return Gui::plainTextEditor()->toPlainText();
+    m_text.compact();
+    return m_text.toString();
 }
 
 void Book::setText(const QString& text)
 {
-    Gui::plainTextEditor()->setPlainText(text);
+    m_text.setText(Formatting::normalizeEditorText(text));
+    m_textStatistics.reset(m_text);
+    m_elementIndex.reset(m_text);
+    if (Gui::hasPlainTextEditor()) {
+        Gui::plainTextEditor()->loadText(m_text);
+    }
+    emit textChanged();
+}
+
+PieceTable Book::getTextSnapshot() const
+{
+    return m_text;
+}
+
+int Book::getTextLength() const
+{
+    return m_text.length();
+}
+
+const TextStatistics& Book::getTextStatistics() const
+{
+    return m_textStatistics;
+}
+
+void Book::updateText(int position, int charsRemoved, const QString &added)
+{
+    Q_ASSERT(position >= 0 && position + charsRemoved <= m_text.length());
+    m_textStatistics.beginChange(m_text, position, charsRemoved);
+    m_text.replace(position, charsRemoved, added);
+    m_textStatistics.endChange(m_text, position, added.length());
+    m_elementIndex.update(m_text, position, charsRemoved, added.length());
+    emit textChanged();
+}
+
+void Book::replaceText(const QVector<TextReplacement> &replacements)
+{
+    if (replacements.isEmpty()) {
+        return;
+    }
+    if (Gui::hasPlainTextEditor()) {
+        Gui::plainTextEditor()->replace(replacements);
+        return;
+    }
+    //from the end, so positions of remaining replacements stay valid
+    for (int i = replacements.size() - 1; i >= 0; --i) {
+        const TextReplacement &replacement = replacements[i];
+        updateText(replacement.position, replacement.length, replacement.after);
+    }
+}
+
+XMLElement Book::findXMLElement(const QString &element, int from) const
+{
+    return m_elementIndex.find(element, from);
+}
+
+QList<XMLElement> Book::findXMLElements(const QString &element) const
+{
+    return m_elementIndex.findAll(element);
 }
 
 int Book::getPicturesCount() const
@@ -216,56 +315,132 @@ int Book::getPicturesCount() const
     return m_pictures.size();
 }
 
-void Book::addPicture(const BookPicture & picture)
+int Book::addPicture(const BookPicture &picture)
 {
+    if (m_pictureHashes.size() != m_pictures.size()) {
+        m_pictureHashes.clear();
+        for (int i = 0; i < m_pictures.size(); ++i) {
+            m_pictureHashes.insert(m_pictures[i].getHash(), i);
+        }
+    }
+    const QByteArray hash = picture.getHash();
+    QHash<QByteArray, int>::const_iterator found = m_pictureHashes.constFind(hash);
+    if (found != m_pictureHashes.constEnd() &&
+        m_pictures[found.value()].getCurrentPictureData() == picture.getCurrentPictureData())
+    {
+        return found.value();
+    }
     m_pictures.push_back(picture);
+    m_pictureHashes.insert(hash, m_pictures.size() - 1);
+    return m_pictures.size() - 1;
 }
 
 void Book::removePicture(int index, bool removeFromDocument)
 {
     m_pictures.removeAt(index);
-    if (removeFromDocument)
-    {
-        int from = 0;
-        XMLElement element;
-        do
-        {
-            element = Gui::plainTextEditor()->findXMLElement("img", from);
-            if (element.startPos() == -1 || element.endPos() == -1) {
-                break;
-            }
-
-            from = element.endPos() + 1;
-
-            if (!element.hasAttribute(XMLElement::BOOK_INDEX_ATTRIBUTE)) {
-                continue;
-            }
-
-            bool ok = false;
-            int currentImage = element.attribute(XMLElement::BOOK_INDEX_ATTRIBUTE).toInt(&ok);
-            if (ok) {
-                if (index == currentImage) {
-                    int start = element.startPos();
-                    int length = element.endPos() - element.startPos();
-                    Gui::plainTextEditor()->replace(start, length, QString());
-                }
-                else if (currentImage > index) {
-                    int start = element.startPos();
-                    int length = element.endPos() - element.startPos();
-                    element.setAttribute(XMLElement::BOOK_INDEX_ATTRIBUTE, QString::number(currentImage - 1));
-                    Gui::plainTextEditor()->replace(start, length, element.formatElement());
-                }
-            }
-        } while (true);
+    m_pictureHashes.clear();
+    QVector<int> newIndexes(m_pictures.size() + 1);
+    for (int i = 0; i < newIndexes.size(); ++i) {
+        newIndexes[i] = i < index ? i : i == index ? -1 : i - 1;
+    }
+    //cover and thumbnail follow the renumbered pictures
+    if (m_coverPicture >= 0 && m_coverPicture < newIndexes.size()) {
+        m_coverPicture = newIndexes[m_coverPicture];
+    }
+    if (m_thumbnailPicture >= 0 && m_thumbnailPicture < newIndexes.size()) {
+        m_thumbnailPicture = newIndexes[m_thumbnailPicture];
+    }
+    if (removeFromDocument) {
+        replaceText(renumberPictures(findXMLElements("img"), newIndexes));
     }
 }
 
-BookPicture Book::getPicture(int index) const
+const BookPicture& Book::getPicture(int index) const
 {
     Q_ASSERT(index >= 0 && index < m_pictures.size());
     return m_pictures[index];
 }
 
+QList<int> Book::importPictures(const QStringList &fileNames)
+{
+    QList<QByteArray> pictures;
+    foreach (const QString &fileName, fileNames) {
+        QFile file(fileName);
+        if (file.open(QIODevice::ReadOnly)) {
+            pictures.append(file.readAll());
+        }
+        else {
+            qDebug() << "Cannot open picture" << fileName << file.errorString();
+            pictures.append(QByteArray());
+        }
+    }
+    ImageOptimizer optimizer(DeviceConfiguration::instance().getScreenSize());
+    optimizer.setCompatibleFormatsOnly(true);
+    const QList<QByteArray> optimized = optimizer.optimize(pictures);
+    QList<int> indexes;
+    foreach (const QByteArray &picture, optimized) {
+        const QByteArray format = BookPicture::detectFormat(picture);
+        if ((format == "JPG" || format == "GIF") && picture.size() <= ImageOptimizer::MAX_PICTURE_SIZE) {
+            indexes.append(addPicture(BookPicture(picture)));
+        }
+        else {
+            indexes.append(-1);
+        }
+    }
+    return indexes;
+}
+
+QString Book::pictureReference(int index)
+{
+    return QString("%1").arg(index + 1, 5, 10, QChar('0'));
+}
+
+int Book::pictureIndex(const QString &reference)
+{
+    bool ok = false;
+    const int index = reference.toInt(&ok) - 1;
+    return ok && index >= 0 ? index : -1;
+}
+
+QVector<TextReplacement> Book::renumberPictures(const QList<XMLElement> &images, const QVector<int> &newIndexes)
+{
+    QVector<TextReplacement> replacements;
+    foreach (XMLElement element, images) {
+        const int index = pictureIndex(element.attribute(XMLElement::BOOK_INDEX_ATTRIBUTE));
+        if (index < 0 || index >= newIndexes.size() || newIndexes[index] == index) {
+            continue;
+        }
+        TextReplacement replacement;
+        replacement.position = element.startPos();
+        replacement.length = element.endPos() - element.startPos();
+        if (newIndexes[index] != -1) {
+            element.setAttribute(XMLElement::BOOK_INDEX_ATTRIBUTE, pictureReference(newIndexes[index]));
+            replacement.after = element.formatElement();
+        }
+        replacements.append(replacement);
+    }
+    return replacements;
+}
+
+qint64 Book::optimizePictures()
+{
+    QList<QByteArray> pictures;
+    foreach (const BookPicture &picture, m_pictures) {
+        pictures.append(picture.getCurrentPictureData());
+    }
+    ImageOptimizer optimizer(DeviceConfiguration::instance().getScreenSize());
+    const QList<QByteArray> optimized = optimizer.optimize(pictures);
+    qint64 saved = 0;
+    for (int i = 0; i < m_pictures.size(); ++i) {
+        if (!optimized[i].isEmpty() && optimized[i] != pictures[i]) {
+            saved += pictures[i].size() - optimized[i].size();
+            m_pictures[i].setPicture(optimized[i]);
+        }
+    }
+    m_pictureHashes.clear();
+    return saved;
+}
+
 QString Book::getFileName() const
 {
     return m_fileName;
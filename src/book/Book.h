@@ -23,11 +23,25 @@
 #define BLACK_MILORD_BOOK_H
 
 #include <QDateTime>
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QHash>
 #include "MetadataEnum.h"
 #include "BookPicture.h"
+#include "PieceTable.h"
+#include "TextStatistics.h"
+#include "ElementIndex.h"
 
-class QString;
 class QVariant;
+class QStringList;
+
+struct TextReplacement
+{
+    int position;
+    int length;
+    QString after;
+};
 
 class Book : public QObject
 {
@@ -48,12 +62,54 @@ public:
     //text accessors
     QString getText() const;
     void setText(const QString &text);
+    /**
+     * Copy of the text which may be read without copying the whole document,
+     * also from other threads.
+     */
+    PieceTable getTextSnapshot() const;
+    int getTextLength() const;
+    const TextStatistics& getTextStatistics() const;
+    //called by the editor for every change made in the document
+    void updateText(int position, int charsRemoved, const QString &added);
+    /**
+     * Applies all replacements as a single undo step, replacements must be sorted
+     * by position and must not overlap.
+     */
+    void replaceText(const QVector<TextReplacement> &replacements);
+
+    //elements of the text, lookups use the index maintained on every change
+    XMLElement findXMLElement(const QString &element, int from = 0) const;
+    QList<XMLElement> findXMLElements(const QString &element) const;
     //pictures accessors
     int getPicturesCount() const;
-    void addPicture(const BookPicture &picture);
+    /**
+     * Pictures are stored only once, adding the same data again gives the index
+     * of the picture already stored.
+     * @return index of the picture.
+     */
+    int addPicture(const BookPicture &picture);
     void removePicture(int index, bool removeFromDocument);
-    BookPicture getPicture(int index) const;
-
+    const BookPicture& getPicture(int index) const;
+    /**
+     * Re-encodes pictures which do not fit into an image record or are larger than the device screen.
+     * @return number of bytes saved.
+     */
+    qint64 optimizePictures();
+    /**
+     * Adds pictures from files, transcoded in parallel to JPEG or GIF fitting into an image record.
+     * @return index of the picture for every file, -1 for files which are not pictures.
+     */
+    QList<int> importPictures(const QStringList &fileNames);
+
+    //value of the recindex attribute of img elements, references count pictures from 1
+    static QString pictureReference(int index);
+    //index of the picture or -1 for an invalid reference
+    static int pictureIndex(const QString &reference);
+    /**
+     * Replacements which update picture references of img elements.
+     * @param newIndexes new index for every picture, -1 removes elements referring to the picture.
+     */
+    static QVector<TextReplacement> renumberPictures(const QList<XMLElement> &images, const QVector<int> &newIndexes);
     //book metadata
     QVariant getMetadata(MetaData metadata) const;
 
@@ -77,18 +133,29 @@ signals:
 private:
     void reset();
 
+    //text is compacted lazily on read
+    mutable PieceTable m_text;
+    TextStatistics m_textStatistics;
+    ElementIndex m_elementIndex;
+
     //book metadata
     QList<BookPicture> m_pictures;
+    //picture index by data hash, rebuilt when it does not match the pictures
+    QHash<QByteArray, int> m_pictureHashes;
     QString m_author;
     QString m_publisher;
     QString m_description;
     QString m_isbn;
     QString m_subject;
+    QString m_language;
     quint16 m_version;
     QDateTime m_creationDate;
     QDateTime m_modificationDate;
     QDateTime m_lastBackupDate;
     quint32 m_modificationNumber;
+    QByteArray m_exthRecords;
+    int m_coverPicture;
+    int m_thumbnailPicture;
 
     //internal metadata
     bool m_fileOpened;
@@ -0,0 +1,50 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_BOOK_METADATA_H
+#define BLACK_MILORD_BOOK_METADATA_H
+
+#include <QString>
+#include <QMap>
+#include <QVariant>
+#include <QByteArray>
+#include "MetadataEnum.h"
+
+/**
+ * Metadata of a book file read without loading its text and pictures.
+ * Filled by AbstractBook::readMetadata, it does not touch the opened Book.
+ */
+struct BookMetadata
+{
+    BookMetadata() :
+        valid(false)
+    {
+    }
+
+    QString fileName;
+    QMap<MetaData, QVariant> values;
+    //raw data of the cover picture, empty when the book has no cover
+    QByteArray cover;
+    bool valid;
+    QString why;
+};
+
+#endif /* BLACK_MILORD_BOOK_METADATA_H */
@@ -21,7 +21,23 @@
 
 #include "BookPicture.h"
 #include <QPixmap>
-#include <QBuffer>
+#include <QImage>
+#include <QCryptographicHash>
+#include <QDebug>
+
+#include <ImageOptimizer.h>
+#include <DeviceConfiguration.h>
+
+namespace {
+    //decoding with known format skips probing of all image plugins
+    QPixmap decodePicture(const QByteArray &pictureData)
+    {
+        const QByteArray format = BookPicture::detectFormat(pictureData);
+        QPixmap image;
+        image.loadFromData(pictureData, format.isEmpty() ? NULL : format.constData());
+        return image;
+    }
+}
 
 BookPicture::BookPicture(const QByteArray &pictureData) :
     m_original(NULL),
@@ -33,44 +49,73 @@ BookPicture::~BookPicture()
 {
 }
 
+QByteArray BookPicture::detectFormat(const QByteArray &pictureData)
+{
+    if (pictureData.startsWith("\xFF\xD8\xFF")) {
+        return "JPG";
+    }
+    if (pictureData.startsWith("GIF87a") || pictureData.startsWith("GIF89a")) {
+        return "GIF";
+    }
+    if (pictureData.startsWith("\x89PNG\r\n\x1A\n")) {
+        return "PNG";
+    }
+    if (pictureData.startsWith("BM") && pictureData.size() > 14) {
+        return "BMP";
+    }
+    return QByteArray();
+}
+
+QByteArray BookPicture::getFormat() const
+{
+    Q_ASSERT(NULL != m_current.data());
+    return detectFormat(*m_current);
+}
 
 QPixmap BookPicture::getOriginalPicture() const
 {
     Q_ASSERT(NULL != m_current.data());
-    QPixmap image;
-    image.loadFromData(m_original.isNull() ? *m_current : *m_original);
-    return image;
+    return decodePicture(m_original.isNull() ? *m_current : *m_original);
 }
 
 QPixmap BookPicture::getCurrentPicture() const
 {
     Q_ASSERT(NULL != m_current.data());
-    QPixmap image;
-    image.loadFromData(*m_current);
-    return image;
+    return decodePicture(*m_current);
 }
 
-QByteArray BookPicture::getOriginalPictureData() const
+const QByteArray& BookPicture::getOriginalPictureData() const
 {
     return m_original.isNull() ? *m_current : *m_original;
 }
 
-QByteArray BookPicture::getCurrentPictureData() const
+const QByteArray& BookPicture::getCurrentPictureData() const
 {
     return *m_current;
 }
 
+QByteArray BookPicture::getHash() const
+{
+    if (m_hash.isEmpty()) {
+        m_hash = QCryptographicHash::hash(*m_current, QCryptographicHash::Sha1);
+    }
+    return m_hash;
+}
+
 
 void BookPicture::setPicture(const QPixmap &picture)
 {
+    ImageOptimizer optimizer(DeviceConfiguration::instance().getScreenSize());
+    const QByteArray pictureData = optimizer.optimize(picture.toImage());
+    if (pictureData.isEmpty()) {
+        qDebug() << "Picture is not changed, it cannot be encoded";
+        return;
+    }
     if (m_original.isNull()) {
         m_original = m_current;
     }
-    m_current = QSharedPointer<QByteArray>(new QByteArray());
-    QBuffer buffer(m_current.data());
-    buffer.open(QIODevice::WriteOnly);
-    //TODO: check if smaller than 63kb
-    picture.save(&buffer, "JPG");
+    m_current = QSharedPointer<QByteArray>(new QByteArray(pictureData));
+    m_hash.clear();
 }
 
 void BookPicture::setPicture(const QByteArray &pictureData)
@@ -79,6 +124,7 @@ void BookPicture::setPicture(const QByteArray &pictureData)
         m_original = m_current;
     }
     m_current = QSharedPointer<QByteArray>(new QByteArray(pictureData));
+    m_hash.clear();
 }
 
 bool BookPicture::isModified() const
@@ -33,10 +33,21 @@ class BookPicture
 public:
     explicit BookPicture(const QByteArray &pictureData);
     virtual ~BookPicture();
+
+    /**
+     * Recognizes image format by its first bytes, without decoding the image.
+     * @return format name accepted by QImageReader or an empty array for unknown data.
+     */
+    static QByteArray detectFormat(const QByteArray &pictureData);
+
+    QByteArray getFormat() const;
     QPixmap getOriginalPicture() const;
     QPixmap getCurrentPicture() const;
-    QByteArray getOriginalPictureData() const;
-    QByteArray getCurrentPictureData() const;
+    //data is shared by all copies of the picture
+    const QByteArray& getOriginalPictureData() const;
+    const QByteArray& getCurrentPictureData() const;
+    //hash of the current data, computed once for every data set
+    QByteArray getHash() const;
     void setPicture(const QPixmap &picture);
     void setPicture(const QByteArray &pictureData);
     bool isModified() const;
@@ -50,6 +61,7 @@ private:
     QSharedPointer<QByteArray> m_current;
     QString m_htmlIndex;
     QString m_filePath;
+    mutable QByteArray m_hash;
 };
 
 #endif /* BLACK_MILORD_BOOK_PICTURE_H */
\ No newline at end of file
@@ -0,0 +1,326 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "ElementIndex.h"
+#include "PieceTable.h"
+
+namespace {
+    bool isNameCharacter(QChar c)
+    {
+        return c.isLetterOrNumber() || c == ':' || c == '_' || c == '-' || c == '.';
+    }
+}
+
+ElementIndex::ElementIndex() :
+    m_length(0)
+{
+    m_opens.gap = 0;
+    m_closes.gap = 0;
+}
+
+void ElementIndex::reset(const PieceTable &text)
+{
+    m_elements.clear();
+    m_opens.items.clear();
+    m_closes.items.clear();
+    const QString data = text.toString();
+    m_length = data.length();
+
+    QHash<QString, Elements> found;
+    scan(data.constData(), data.length(), 0, found);
+    for (QHash<QString, Elements>::ConstIterator it = found.constBegin(); it != found.constEnd(); ++it) {
+        GapList<Element> &elements = m_elements[it.key()];
+        elements.items = it.value();
+        elements.gap = elements.items.size();
+    }
+    scanBrackets(data.constData(), data.length(), 0, m_opens.items, m_closes.items);
+    m_opens.gap = m_opens.items.size();
+    m_closes.gap = m_closes.items.size();
+}
+
+void ElementIndex::update(const PieceTable &text, int position, int charsRemoved, int charsAdded)
+{
+    const int oldLength = m_length;
+    const int delta = charsAdded - charsRemoved;
+    Q_ASSERT(oldLength + delta == text.length());
+    const int editEnd = position + charsAdded;
+
+    //brackets of the edited text are replaced, the ones after it move with the end of the text
+    removeRange(m_opens, position, position + charsRemoved, oldLength);
+    removeRange(m_closes, position, position + charsRemoved, oldLength);
+    QVector<int> opens;
+    QVector<int> closes;
+    const QString added = text.mid(position, charsAdded);
+    scanBrackets(added.constData(), added.length(), position, opens, closes);
+    insertAtGap(m_opens, opens);
+    insertAtGap(m_closes, closes);
+    m_length = text.length();
+
+    //tag which was not finished before the change may be finished by it
+    int windowStart = position;
+    const int open = bracketBefore(m_opens, position);
+    if (open != -1 && bracketBefore(m_closes, position) < open) {
+        windowStart = open;
+    }
+    //tag left open by the change ends at the next '>', unless '<' comes first
+    int windowEnd = editEnd;
+    const int lastOpen = bracketBefore(m_opens, editEnd);
+    if (lastOpen >= windowStart && bracketBefore(m_closes, editEnd) < lastOpen) {
+        const int nextOpen = bracketAfter(m_opens, editEnd);
+        const int nextClose = bracketAfter(m_closes, editEnd);
+        if (nextClose != -1 && (nextOpen == -1 || nextClose < nextOpen)) {
+            windowEnd = nextClose + 1;
+        }
+    }
+
+    QHash<QString, Elements> found;
+    const QString window = text.mid(windowStart, windowEnd - windowStart);
+    scan(window.constData(), window.length(), windowStart, found);
+
+    //elements before the window are not changed, elements after it are stored from the end
+    QHash<QString, GapList<Element> >::Iterator it = m_elements.begin();
+    while (it != m_elements.end()) {
+        GapList<Element> &elements = it.value();
+        removeRange(elements, windowStart, windowEnd - delta, oldLength);
+        QHash<QString, Elements>::Iterator foundIt = found.find(it.key());
+        if (foundIt != found.end()) {
+            insertAtGap(elements, foundIt.value());
+            found.erase(foundIt);
+        }
+        if (elements.items.isEmpty()) {
+            it = m_elements.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    for (QHash<QString, Elements>::ConstIterator foundIt = found.constBegin(); foundIt != found.constEnd(); ++foundIt) {
+        GapList<Element> &elements = m_elements[foundIt.key()];
+        elements.items = foundIt.value();
+        elements.gap = elements.items.size();
+    }
+}
+
+XMLElement ElementIndex::find(const QString &name, int from) const
+{
+    QHash<QString, GapList<Element> >::ConstIterator it = m_elements.find(name.toLower());
+    if (it != m_elements.end()) {
+        const int index = lowerBound(it.value(), from, m_length);
+        if (index < it.value().items.size()) {
+            return toXMLElement(name, itemAt(it.value(), index, m_length));
+        }
+    }
+    return XMLElement(name);
+}
+
+QList<XMLElement> ElementIndex::findAll(const QString &name) const
+{
+    QList<XMLElement> result;
+    QHash<QString, GapList<Element> >::ConstIterator it = m_elements.find(name.toLower());
+    if (it != m_elements.end()) {
+        for (int i = 0; i < it.value().items.size(); ++i) {
+            result.append(toXMLElement(name, itemAt(it.value(), i, m_length)));
+        }
+    }
+    return result;
+}
+
+void ElementIndex::scan(const QChar *text, int length, int offset, QHash<QString, Elements> &found)
+{
+    int position = 0;
+    while (position < length) {
+        if (text[position] != '<') {
+            ++position;
+            continue;
+        }
+        int end = position + 1;
+        while (end < length && text[end] != '<' && text[end] != '>') {
+            ++end;
+        }
+        if (end == length || text[end] == '<') {
+            position = end;
+            continue;
+        }
+
+        int nameStart = position + 1;
+        while (nameStart < end && text[nameStart].isSpace()) {
+            ++nameStart;
+        }
+        int nameEnd = nameStart;
+        if (nameEnd < end && text[nameEnd].isLetter()) {
+            while (nameEnd < end && isNameCharacter(text[nameEnd])) {
+                ++nameEnd;
+            }
+        }
+        if (nameEnd > nameStart) {
+            Element element;
+            element.start = offset + position;
+            element.end = offset + end + 1;
+            element.attributes = parseAttributes(text + nameEnd, end - nameEnd);
+            found[QString(text + nameStart, nameEnd - nameStart).toLower()].append(element);
+        }
+        position = end + 1;
+    }
+}
+
+QMap<QString, QString> ElementIndex::parseAttributes(const QChar *text, int length)
+{
+    QMap<QString, QString> attributes;
+    int position = 0;
+    while (position < length) {
+        if (!text[position].isLetter()) {
+            ++position;
+            continue;
+        }
+        const int nameStart = position;
+        while (position < length && isNameCharacter(text[position])) {
+            ++position;
+        }
+        const QString name(text + nameStart, position - nameStart);
+        while (position < length && text[position].isSpace()) {
+            ++position;
+        }
+        if (position == length || text[position] != '=') {
+            continue;
+        }
+        ++position;
+        while (position < length && text[position].isSpace()) {
+            ++position;
+        }
+        if (position == length) {
+            break;
+        }
+        int valueStart = position;
+        int valueEnd;
+        if (text[position] == '"' || text[position] == '\'') {
+            const QChar quote = text[position];
+            valueStart = ++position;
+            while (position < length && text[position] != quote) {
+                ++position;
+            }
+            valueEnd = position++;
+        }
+        else {
+            while (position < length && !text[position].isSpace() && text[position] != '/') {
+                ++position;
+            }
+            valueEnd = position;
+        }
+        attributes.insert(name, QString(text + valueStart, valueEnd - valueStart));
+    }
+    return attributes;
+}
+
+void ElementIndex::scanBrackets(const QChar *text, int length, int offset, QVector<int> &opens, QVector<int> &closes)
+{
+    for (int i = 0; i < length; ++i) {
+        if (text[i] == '<') {
+            opens.append(offset + i);
+        }
+        else if (text[i] == '>') {
+            closes.append(offset + i);
+        }
+    }
+}
+
+template <typename T>
+T ElementIndex::itemAt(const GapList<T> &list, int index, int length)
+{
+    T item = list.items[index];
+    if (index >= list.gap) {
+        shift(item, length);
+    }
+    return item;
+}
+
+template <typename T>
+int ElementIndex::lowerBound(const GapList<T> &list, int position, int length)
+{
+    int first = 0;
+    int count = list.items.size();
+    while (count > 0) {
+        const int step = count / 2;
+        const int index = first + step;
+        const int start = startOf(list.items[index]) + (index >= list.gap ? length : 0);
+        if (start < position) {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+template <typename T>
+void ElementIndex::moveGap(GapList<T> &list, int to, int length)
+{
+    for (; list.gap < to; ++list.gap) {
+        shift(list.items[list.gap], length);
+    }
+    while (list.gap > to) {
+        --list.gap;
+        shift(list.items[list.gap], -length);
+    }
+}
+
+template <typename T>
+void ElementIndex::removeRange(GapList<T> &list, int from, int to, int length)
+{
+    moveGap(list, lowerBound(list, from, length), length);
+    const int last = lowerBound(list, to, length);
+    list.items.remove(list.gap, last - list.gap);
+}
+
+template <typename T>
+void ElementIndex::insertAtGap(GapList<T> &list, const QVector<T> &items)
+{
+    if (items.isEmpty()) {
+        return;
+    }
+    list.items.insert(list.gap, items.size(), T());
+    for (int i = 0; i < items.size(); ++i) {
+        list.items[list.gap + i] = items[i];
+    }
+    list.gap += items.size();
+}
+
+int ElementIndex::bracketBefore(const GapList<int> &brackets, int position) const
+{
+    const int index = lowerBound(brackets, position, m_length);
+    return index > 0 ? itemAt(brackets, index - 1, m_length) : -1;
+}
+
+int ElementIndex::bracketAfter(const GapList<int> &brackets, int position) const
+{
+    const int index = lowerBound(brackets, position, m_length);
+    return index < brackets.items.size() ? itemAt(brackets, index, m_length) : -1;
+}
+
+XMLElement ElementIndex::toXMLElement(const QString &name, const Element &element)
+{
+    XMLElement result(name);
+    result.setStartPos(element.start);
+    result.setEndPos(element.end);
+    result.setAttributes(element.attributes);
+    return result;
+}
@@ -0,0 +1,102 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_ELEMENT_INDEX_H
+#define BLACK_MILORD_ELEMENT_INDEX_H
+
+#include <QString>
+#include <QMap>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <XMLElement.h>
+
+class PieceTable;
+class QChar;
+
+/**
+ * Positions and attributes of the opening tags in the text, grouped by element name.
+ * A tag starts with '<' and ends with the first following '>', unless another '<' comes first.
+ * Positions of all '<' and '>' are kept too, so a change rescans only the edited text
+ * and the tag it may have opened or closed.
+ * Items after the gap of a list are stored relative to the end of the text, so an edit
+ * does not move them, only the items between the old and the new gap are converted.
+ */
+class ElementIndex
+{
+public:
+    ElementIndex();
+
+    void reset(const PieceTable &text);
+    //called with the text after the change
+    void update(const PieceTable &text, int position, int charsRemoved, int charsAdded);
+
+    //first element starting at or after from, element names are case insensitive
+    XMLElement find(const QString &name, int from = 0) const;
+    QList<XMLElement> findAll(const QString &name) const;
+
+private:
+    struct Element {
+        int start;
+        int end;
+        QMap<QString, QString> attributes;
+    };
+    typedef QVector<Element> Elements;
+
+    template <typename T>
+    struct GapList {
+        QVector<T> items;
+        int gap;
+    };
+
+    static void scan(const QChar *text, int length, int offset, QHash<QString, Elements> &found);
+    static void scanBrackets(const QChar *text, int length, int offset, QVector<int> &opens, QVector<int> &closes);
+    static QMap<QString, QString> parseAttributes(const QChar *text, int length);
+    static XMLElement toXMLElement(const QString &name, const Element &element);
+
+    static int startOf(int position) { return position; }
+    static int startOf(const Element &element) { return element.start; }
+    static void shift(int &position, int delta) { position += delta; }
+    static void shift(Element &element, int delta) { element.start += delta; element.end += delta; }
+
+    template <typename T>
+    static T itemAt(const GapList<T> &list, int index, int length);
+    template <typename T>
+    static int lowerBound(const GapList<T> &list, int position, int length);
+    template <typename T>
+    static void moveGap(GapList<T> &list, int to, int length);
+    //removes items starting in [from, to) and leaves the gap in their place
+    template <typename T>
+    static void removeRange(GapList<T> &list, int from, int to, int length);
+    template <typename T>
+    static void insertAtGap(GapList<T> &list, const QVector<T> &items);
+
+    //last bracket before position and first one at or after it, -1 when there is none
+    int bracketBefore(const GapList<int> &brackets, int position) const;
+    int bracketAfter(const GapList<int> &brackets, int position) const;
+
+    QHash<QString, GapList<Element> > m_elements;
+    GapList<int> m_opens;
+    GapList<int> m_closes;
+    int m_length;
+};
+
+#endif /* BLACK_MILORD_ELEMENT_INDEX_H */
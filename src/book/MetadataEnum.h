@@ -29,11 +29,17 @@ enum MetaData
     METADATA_DESCRIPTION,
     METADATA_ISBN,
     METADATA_SUBJECT,
+    METADATA_LANGUAGE,
     METADATA_VERSION,
     METADATA_CREATION_DATE,
     METADATA_MODIFICATION_DATE,
     METADATA_LAST_BACKUP_DATE,
-    METADATA_MODIFICATION_NUMBER
+    METADATA_MODIFICATION_NUMBER,
+    //EXTH records of the file as read, so records not handled by the editor survive saving
+    METADATA_EXTH_RECORDS,
+    //indexes of the pictures used as cover and thumbnail, -1 when there is none
+    METADATA_COVER_PICTURE,
+    METADATA_THUMBNAIL_PICTURE
 
 };
 
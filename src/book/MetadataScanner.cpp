@@ -0,0 +1,77 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "MetadataScanner.h"
+#include <QThreadPool>
+#include <QRunnable>
+#include <QVector>
+#include <QDir>
+
+#include "AbstractBook.h"
+
+namespace {
+    class ScanTask :
+        public QRunnable
+    {
+    public:
+        ScanTask(const QString &fileName, BookMetadata &result) :
+            m_fileName(fileName),
+            m_result(result)
+        {
+        }
+
+        void run()
+        {
+            //every file gets its own reader, they share nothing
+            AbstractBookFactory::getObject()->readMetadata(m_fileName, m_result);
+        }
+
+    private:
+        const QString m_fileName;
+        BookMetadata &m_result;
+    };
+}
+
+QList<BookMetadata> MetadataScanner::scan(const QStringList &fileNames, int maxThreads)
+{
+    QVector<BookMetadata> results(fileNames.size());
+    QThreadPool pool;
+    if (maxThreads > 0) {
+        pool.setMaxThreadCount(maxThreads);
+    }
+    for (int i = 0; i < fileNames.size(); ++i) {
+        pool.start(new ScanTask(fileNames[i], results[i]));
+    }
+    pool.waitForDone();
+    return results.toList();
+}
+
+QStringList MetadataScanner::bookFiles(const QString &directory)
+{
+    QDir dir(directory);
+    QStringList result;
+    QStringList names = dir.entryList(QStringList() << "*.mobi" << "*.prc",
+                                      QDir::Files | QDir::Readable, QDir::Name);
+    for (int i = 0; i < names.size(); ++i) {
+        result.append(dir.absoluteFilePath(names[i]));
+    }
+    return result;
+}
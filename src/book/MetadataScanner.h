@@ -0,0 +1,46 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_METADATA_SCANNER_H
+#define BLACK_MILORD_METADATA_SCANNER_H
+
+#include <QList>
+#include <QStringList>
+#include "BookMetadata.h"
+
+/**
+ * Reads metadata of many books at once, for listing a library.
+ * Only headers and covers are read, files are processed in parallel.
+ */
+class MetadataScanner
+{
+public:
+    /**
+     * Scans files using up to maxThreads threads, ideal thread count is used when it is not positive.
+     * Blocks until all files are done, results are in order of fileNames.
+     */
+    static QList<BookMetadata> scan(const QStringList &fileNames, int maxThreads = 0);
+
+    //book files directly in the directory, sorted by name
+    static QStringList bookFiles(const QString &directory);
+};
+
+#endif /* BLACK_MILORD_METADATA_SCANNER_H */
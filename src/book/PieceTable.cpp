@@ -0,0 +1,237 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "PieceTable.h"
+#include <QtAlgorithms>
+
+namespace {
+    //typing appends to the last inserted buffer while it is small,
+    //appending to a shared buffer copies it
+    const int MAX_APPEND_BUFFER = 4096;
+    //long editing sessions are joined back into a single piece
+    const int MAX_PIECES = 8192;
+}
+
+PieceTable::PieceTable() :
+    m_length(0)
+{
+}
+
+PieceTable::PieceTable(const QString &text) :
+    m_length(0)
+{
+    setText(text);
+}
+
+void PieceTable::setText(const QString &text)
+{
+    m_pieces.clear();
+    m_offsets.clear();
+    m_length = text.length();
+    if (!text.isEmpty()) {
+        Piece piece;
+        piece.buffer = text;
+        piece.start = 0;
+        piece.length = text.length();
+        m_pieces.push_back(piece);
+        m_offsets.push_back(0);
+    }
+}
+
+void PieceTable::replace(int position, int length, const QString &after)
+{
+    Q_ASSERT(position >= 0 && length >= 0 && position + length <= m_length);
+    if (length == 0 && after.isEmpty()) {
+        return;
+    }
+    int first = splitAt(position);
+    int last = splitAt(position + length);
+    m_pieces.remove(first, last - first);
+    m_offsets.remove(first, last - first);
+
+    if (!after.isEmpty()) {
+        Piece *previous = first > 0 ? &m_pieces[first - 1] : NULL;
+        if (previous &&
+            previous->start + previous->length == previous->buffer.length() &&
+            previous->buffer.length() + after.length() <= MAX_APPEND_BUFFER)
+        {
+            previous->buffer.append(after);
+            previous->length += after.length();
+        }
+        else {
+            Piece piece;
+            piece.buffer = after;
+            piece.start = 0;
+            piece.length = after.length();
+            m_pieces.insert(first, piece);
+            m_offsets.insert(first, position);
+        }
+    }
+    m_length += after.length() - length;
+    updateOffsets(first);
+
+    if (m_pieces.size() > MAX_PIECES) {
+        compact();
+    }
+}
+
+void PieceTable::compact()
+{
+    if (m_pieces.size() > 1 ||
+        (m_pieces.size() == 1 && m_pieces[0].length != m_pieces[0].buffer.length()))
+    {
+        setText(toString());
+    }
+}
+
+int PieceTable::length() const
+{
+    return m_length;
+}
+
+bool PieceTable::isEmpty() const
+{
+    return m_length == 0;
+}
+
+QChar PieceTable::at(int position) const
+{
+    Q_ASSERT(position >= 0 && position < m_length);
+    const int index = findPiece(position);
+    const Piece &piece = m_pieces[index];
+    return piece.buffer[piece.start + position - m_offsets[index]];
+}
+
+QString PieceTable::mid(int position, int length) const
+{
+    Q_ASSERT(position >= 0 && length >= 0);
+    length = qMin(length, m_length - position);
+    QString result;
+    if (length <= 0) {
+        return result;
+    }
+    result.reserve(length);
+    for (int index = findPiece(position); length > 0; ++index) {
+        const Piece &piece = m_pieces[index];
+        int offset = position - m_offsets[index];
+        int count = qMin(length, piece.length - offset);
+        result.append(piece.buffer.constData() + piece.start + offset, count);
+        position += count;
+        length -= count;
+    }
+    return result;
+}
+
+int PieceTable::indexOf(QChar c, int from) const
+{
+    Q_ASSERT(from >= 0);
+    if (from >= m_length) {
+        return -1;
+    }
+    for (int index = findPiece(from); index < m_pieces.size(); ++index) {
+        const Piece &piece = m_pieces[index];
+        const QChar *data = piece.buffer.constData() + piece.start;
+        for (int i = qMax(0, from - m_offsets[index]); i < piece.length; ++i) {
+            if (data[i] == c) {
+                return m_offsets[index] + i;
+            }
+        }
+    }
+    return -1;
+}
+
+int PieceTable::lastIndexOf(QChar c, int from) const
+{
+    Q_ASSERT(from < m_length);
+    if (from < 0) {
+        return -1;
+    }
+    for (int index = findPiece(from); index >= 0; --index) {
+        const Piece &piece = m_pieces[index];
+        const QChar *data = piece.buffer.constData() + piece.start;
+        for (int i = qMin(piece.length - 1, from - m_offsets[index]); i >= 0; --i) {
+            if (data[i] == c) {
+                return m_offsets[index] + i;
+            }
+        }
+    }
+    return -1;
+}
+
+QString PieceTable::toString() const
+{
+    if (m_pieces.size() == 1 && m_pieces[0].length == m_pieces[0].buffer.length()) {
+        return m_pieces[0].buffer;
+    }
+    QString result;
+    result.reserve(m_length);
+    foreach (const Piece &piece, m_pieces) {
+        result.append(piece.buffer.constData() + piece.start, piece.length);
+    }
+    return result;
+}
+
+int PieceTable::chunkCount() const
+{
+    return m_pieces.size();
+}
+
+QStringRef PieceTable::chunk(int index) const
+{
+    const Piece &piece = m_pieces[index];
+    return QStringRef(&piece.buffer, piece.start, piece.length);
+}
+
+int PieceTable::findPiece(int position) const
+{
+    Q_ASSERT(!m_offsets.isEmpty());
+    QVector<int>::const_iterator it = qUpperBound(m_offsets.constBegin(), m_offsets.constEnd(), position);
+    return (it - m_offsets.constBegin()) - 1;
+}
+
+int PieceTable::splitAt(int position)
+{
+    if (position == m_length) {
+        return m_pieces.size();
+    }
+    int index = findPiece(position);
+    int offset = position - m_offsets[index];
+    if (offset == 0) {
+        return index;
+    }
+    Piece tail = m_pieces[index];
+    tail.start += offset;
+    tail.length -= offset;
+    m_pieces[index].length = offset;
+    m_pieces.insert(index + 1, tail);
+    m_offsets.insert(index + 1, position);
+    return index + 1;
+}
+
+void PieceTable::updateOffsets(int from)
+{
+    if (!m_offsets.isEmpty()) {
+        m_offsets[0] = 0;
+    }
+    for (int i = qMax(from, 1); i < m_pieces.size(); ++i) {
+        m_offsets[i] = m_offsets[i - 1] + m_pieces[i - 1].length;
+    }
+}
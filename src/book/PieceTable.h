@@ -0,0 +1,82 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_PIECE_TABLE_H
+#define BLACK_MILORD_PIECE_TABLE_H
+
+#include <QString>
+#include <QStringRef>
+#include <QVector>
+
+/**
+ * Text stored as a sequence of pieces of immutable, implicitly shared buffers.
+ * Edits split and insert pieces instead of moving the text, and copying the
+ * table only copies the piece list, so copies are cheap snapshots which may be
+ * handed over to other threads.
+ * A single PieceTable object must not be used by several threads at once.
+ */
+class PieceTable
+{
+public:
+    PieceTable();
+    explicit PieceTable(const QString &text);
+
+    void setText(const QString &text);
+    void replace(int position, int length, const QString &after);
+
+    /**
+     * Joins all pieces into one buffer, next toString() calls return it without copying.
+     */
+    void compact();
+
+    int length() const;
+    bool isEmpty() const;
+    QChar at(int position) const;
+    QString mid(int position, int length) const;
+    //position of the character or -1, searching backward starts at from
+    int indexOf(QChar c, int from = 0) const;
+    int lastIndexOf(QChar c, int from) const;
+    QString toString() const;
+
+    /**
+     * Pieces of the text in order. References are valid until the table is modified.
+     */
+    int chunkCount() const;
+    QStringRef chunk(int index) const;
+
+private:
+    struct Piece {
+        QString buffer;
+        int start;
+        int length;
+    };
+
+    int findPiece(int position) const;
+    int splitAt(int position);
+    void updateOffsets(int from);
+
+    QVector<Piece> m_pieces;
+    //position of the first character of every piece
+    QVector<int> m_offsets;
+    int m_length;
+};
+
+#endif /* BLACK_MILORD_PIECE_TABLE_H */
@@ -0,0 +1,126 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "TextStatistics.h"
+#include <QString>
+#include <WordTokenizer.h>
+#include "PieceTable.h"
+#include "PalmDOCHeader.h"
+
+TextStatistics::TextStatistics() :
+    m_words(0),
+    m_encodedSize(0)
+{
+}
+
+void TextStatistics::reset(const PieceTable &text)
+{
+    m_words = 0;
+    m_encodedSize = 0;
+    const QString data = text.toString();
+    int lineStart = 0;
+    while (lineStart < data.length()) {
+        int lineEnd = data.indexOf('\n', lineStart);
+        if (lineEnd == -1) {
+            lineEnd = data.length();
+        }
+        add(data.constData() + lineStart, lineEnd - lineStart, 1);
+        lineStart = lineEnd + 1;
+    }
+}
+
+void TextStatistics::beginChange(const PieceTable &text, int position, int charsRemoved)
+{
+    add(text, position, charsRemoved, -1);
+}
+
+void TextStatistics::endChange(const PieceTable &text, int position, int charsAdded)
+{
+    add(text, position, charsAdded, 1);
+}
+
+int TextStatistics::wordCount() const
+{
+    return m_words;
+}
+
+qint64 TextStatistics::encodedSize() const
+{
+    return m_encodedSize;
+}
+
+int TextStatistics::recordCount() const
+{
+    return (m_encodedSize + PalmDOCHeader::MAX_RECORD_SIZE - 1) / PalmDOCHeader::MAX_RECORD_SIZE;
+}
+
+void TextStatistics::add(const PieceTable &text, int position, int length, int sign)
+{
+    //whole lines around the range, text outside of them is not changed
+    int lineStart = text.lastIndexOf('\n', position - 1) + 1;
+    int lineEnd = text.indexOf('\n', position + length);
+    if (lineEnd == -1) {
+        lineEnd = text.length();
+    }
+    const QString lines = text.mid(lineStart, lineEnd - lineStart);
+    int start = 0;
+    while (start < lines.length()) {
+        int end = lines.indexOf('\n', start);
+        if (end == -1) {
+            end = lines.length();
+        }
+        add(lines.constData() + start, end - start, sign);
+        start = end + 1;
+    }
+}
+
+void TextStatistics::add(const QChar *text, int length, int sign)
+{
+    int words = 0;
+    int wordStart;
+    int wordEnd;
+    WordTokenizer tokenizer(text, length);
+    tokenizer.setSkipUrls(true);
+    while (tokenizer.nextWord(wordStart, wordEnd)) {
+        ++words;
+    }
+
+    qint64 size = 0;
+    for (int i = 0; i < length; ++i) {
+        const ushort c = text[i].unicode();
+        if (c < 0x80) {
+            ++size;
+        }
+        else if (c < 0x800) {
+            size += 2;
+        }
+        else if (text[i].isHighSurrogate() && i + 1 < length && text[i + 1].isLowSurrogate()) {
+            size += 4;
+            ++i;
+        }
+        else {
+            size += 3;
+        }
+    }
+
+    m_words += sign * words;
+    m_encodedSize += sign * size;
+}
@@ -0,0 +1,61 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_TEXT_STATISTICS_H
+#define BLACK_MILORD_TEXT_STATISTICS_H
+
+#include <QtGlobal>
+
+class PieceTable;
+class QChar;
+
+/**
+ * Word count and size of the text as it is written to the file.
+ * Statistics are collected per line, so a change rescans only the lines it touches.
+ */
+class TextStatistics
+{
+public:
+    TextStatistics();
+
+    void reset(const PieceTable &text);
+
+    /**
+     * Change of the text has to be reported twice, with the text before
+     * and after the change.
+     */
+    void beginChange(const PieceTable &text, int position, int charsRemoved);
+    void endChange(const PieceTable &text, int position, int charsAdded);
+
+    int wordCount() const;
+    //UTF-8 size of the text without line breaks
+    qint64 encodedSize() const;
+    int recordCount() const;
+
+private:
+    void add(const PieceTable &text, int position, int length, int sign);
+    void add(const QChar *text, int length, int sign);
+
+    int m_words;
+    qint64 m_encodedSize;
+};
+
+#endif /* BLACK_MILORD_TEXT_STATISTICS_H */
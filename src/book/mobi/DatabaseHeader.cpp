@@ -47,6 +47,7 @@ DatabaseHeader::~DatabaseHeader()
 
 bool DatabaseHeader::read(QDataStream &data)
 {
+    m_recordInfoEntries.clear();
     data.readRawData(m_databaseName, DATABASE_NAME_LENGTH);
     data >> m_attributes;
     data >> m_version;
@@ -62,18 +63,45 @@ bool DatabaseHeader::read(QDataStream &data)
     data >> m_nextRecordListID;
     data >> m_numberOfRecords;
 
-    quint8 tmp8;
+    if (data.status() != QDataStream::Ok) {
+        m_why = QObject::tr("Invalid header.");
+        return false;
+    }
+    if (m_type != TYPE_BOOK || m_creator != CREATOR_MOBI) {
+        m_why = QObject::tr("This is not a Mobipocket document.");
+        return false;
+    }
+    //TODO: it's not correct, but this is not supported ATM
+    if (m_appInfoID != 0 || m_sortInfoID != 0) {
+        m_why = QObject::tr("Invalid database header.\nappInfoID or sortInfoID is set.\nIt is not supported yet.\nPlease submit yout file to fix it.");
+        return false;
+    }
+
+    //records start after the record list and 2 bytes of gap, all of them have to be in the file
+    const qint64 fileSize = data.device()->size();
+    const qint64 dataStart = data.device()->pos() + RECORD_INFO_ENTRY_SIZE * m_numberOfRecords + 2;
+    if (0 == m_numberOfRecords || dataStart > fileSize) {
+        m_why = QObject::tr("Invalid record list.");
+        return false;
+    }
+
+    //record list is read in one block
+    QByteArray recordList(RECORD_INFO_ENTRY_SIZE * m_numberOfRecords, 0);
+    if (data.readRawData(recordList.data(), recordList.size()) != recordList.size()) {
+        m_why = QObject::tr("Invalid record list.");
+        return false;
+    }
+    m_recordInfoEntries.resize(m_numberOfRecords);
     for (int i = 0; i < m_numberOfRecords; ++i) {
-        DatabaseRecordInfoEntry entry;
-        data >> entry.m_recordDataOffset;
-        data >> entry.m_recordAttributes;
-        data >> tmp8;
-        entry.m_uniqueID = tmp8 << 16;
-        data >> tmp8;
-        entry.m_uniqueID += tmp8 << 8;
-        data >> tmp8;
-        entry.m_uniqueID += tmp8;
-        m_recordInfoEntries.push_back(entry);
+        DatabaseRecordInfoEntry &entry = m_recordInfoEntries[i];
+        HeaderLayout::read(entry, DatabaseRecordInfoEntry::FIELDS,
+                           recordList.constData() + i * RECORD_INFO_ENTRY_SIZE, RECORD_INFO_ENTRY_SIZE);
+        if (entry.m_recordDataOffset < dataStart || entry.m_recordDataOffset > fileSize ||
+            (i != 0 && entry.m_recordDataOffset < m_recordInfoEntries[i - 1].m_recordDataOffset))
+        {
+            m_why = QObject::tr("Invalid record offset.");
+            return false;
+        }
         //entry.print();
         if (i != 0)
         {
@@ -82,24 +110,16 @@ bool DatabaseHeader::read(QDataStream &data)
                 m_recordInfoEntries[i - 1].m_recordDataOffset;
         }
     }
-    data.device()->seek(m_recordInfoEntries[m_numberOfRecords - 1].m_recordDataOffset);
-    m_recordInfoEntries[m_numberOfRecords - 1].m_length = data.skipRawData(65536);
+    //last record ends with the file, only EOF record is expected there
+    m_recordInfoEntries[m_numberOfRecords - 1].m_length =
+        qMin<qint64>(fileSize - m_recordInfoEntries[m_numberOfRecords - 1].m_recordDataOffset, 65536);
 
     quint16 tmp16;
     data >> tmp16;
-    if (tmp16 != 0) {
+    if (data.status() != QDataStream::Ok || tmp16 != 0) {
         m_why = QObject::tr("Invalid header.");
         return false;
     }
-    if (m_type != TYPE_BOOK || m_creator != CREATOR_MOBI) {
-        m_why = QObject::tr("This is not a Mobipocket document.");
-        return false;
-    }
-    //TODO: it's not correct, but this is not supported ATM
-    if (m_appInfoID != 0 || m_sortInfoID != 0) {
-        m_why = QObject::tr("Invalid database header.\nappInfoID or sortInfoID is set.\nIt is not supported yet.\nPlease submit yout file to fix it.");
-        return false;
-    }
     print();
     return true;
 }
@@ -120,13 +140,8 @@ bool DatabaseHeader::write(QDataStream& data)
     data << m_uniqueIDseed;
     data << m_nextRecordListID;
     data << m_numberOfRecords;
-    for (int i=0; i<m_numberOfRecords; ++i) {
-        data << m_recordInfoEntries[i].m_recordDataOffset;
-        data << m_recordInfoEntries[i].m_recordAttributes;
-        data << static_cast<quint8>(m_recordInfoEntries[i].m_uniqueID >> 16 & 0xFF);
-        data << static_cast<quint8>(m_recordInfoEntries[i].m_uniqueID >> 8 & 0xFF);
-        data << static_cast<quint8>(m_recordInfoEntries[i].m_uniqueID & 0xFF);
-    }
+    const QByteArray recordList = recordInfoList();
+    data.writeRawData(recordList.constData(), recordList.size());
     data << static_cast<quint16>(0); //Gap to data.
     return true;
 }
@@ -135,17 +150,23 @@ bool DatabaseHeader::updateRecordInfoEntries(QDataStream &data)
 {
     qint64 pos = data.device()->pos();
     data.device()->seek(78);
-    for (int i=0; i<m_numberOfRecords; ++i) {
-        data << m_recordInfoEntries[i].m_recordDataOffset;
-        data << m_recordInfoEntries[i].m_recordAttributes;
-        data << static_cast<quint8>(m_recordInfoEntries[i].m_uniqueID >> 16 & 0xFF);
-        data << static_cast<quint8>(m_recordInfoEntries[i].m_uniqueID >> 8 & 0xFF);
-        data << static_cast<quint8>(m_recordInfoEntries[i].m_uniqueID & 0xFF);
-    }
+    const QByteArray recordList = recordInfoList();
+    data.writeRawData(recordList.constData(), recordList.size());
     data.device()->seek(pos);
     return true;
 }
 
+QByteArray DatabaseHeader::recordInfoList() const
+{
+    Q_ASSERT(HeaderLayout::size(DatabaseRecordInfoEntry::FIELDS) == RECORD_INFO_ENTRY_SIZE);
+    QByteArray result(RECORD_INFO_ENTRY_SIZE * m_numberOfRecords, 0);
+    for (int i = 0; i < m_numberOfRecords; ++i) {
+        HeaderLayout::write(m_recordInfoEntries[i], DatabaseRecordInfoEntry::FIELDS,
+                            result.data() + i * RECORD_INFO_ENTRY_SIZE);
+    }
+    return result;
+}
+
 void DatabaseHeader::initForWrite()
 {
     memset(m_databaseName, 0, DATABASE_NAME_LENGTH);
@@ -167,9 +188,17 @@ void DatabaseHeader::initForWrite()
     m_recordInfoEntries.clear();
 }
 
+bool DatabaseHeader::hasRecord(int recordIndex) const
+{
+    return recordIndex >= 0 && recordIndex < m_recordInfoEntries.size();
+}
+
 quint32 DatabaseHeader::getRecordOffset(int recordIndex) const
 {
-    Q_ASSERT(recordIndex < m_recordInfoEntries.size());
+    Q_ASSERT(hasRecord(recordIndex));
+    if (!hasRecord(recordIndex)) {
+        return 0;
+    }
     return m_recordInfoEntries[recordIndex].m_recordDataOffset;
 }
 
@@ -180,7 +209,10 @@ void DatabaseHeader::setRecordOffset(int recordIndex, quint32 recordOffset)
 
 quint32 DatabaseHeader::getRecordLength(int recordIndex) const
 {
-    Q_ASSERT(recordIndex < m_recordInfoEntries.size());
+    Q_ASSERT(hasRecord(recordIndex));
+    if (!hasRecord(recordIndex)) {
+        return 0;
+    }
     return m_recordInfoEntries[recordIndex].m_length;
 }
 
@@ -23,6 +23,7 @@
 #define BLACK_MILORD_DATABASE_HEADER_H
 
 #include <QVector>
+#include <QByteArray>
 
 class QDataStream;
 class QString;
@@ -35,6 +36,8 @@ private:
     static const int DATABASE_NAME_LENGTH = 32;
     static const int TYPE_LENGTH = 4;
     static const int CREATOR_LENGTH = 4;
+    //offset, attributes and 3 bytes of unique ID
+    static const int RECORD_INFO_ENTRY_SIZE = 8;
     static const QString TYPE_BOOK;
     static const QString CREATOR_MOBI;
 public:
@@ -44,6 +47,8 @@ public:
     bool write(QDataStream &data);
     bool updateRecordInfoEntries(QDataStream &data);
     void initForWrite();
+    //record indexes read from the file have to be checked before use
+    bool hasRecord(int recordIndex) const;
     quint32 getRecordOffset(int recordIndex) const;
     void setRecordOffset(int recordIndex, quint32 recordOffset);
     quint32 getRecordLength(int recordIndex) const;
@@ -118,6 +123,9 @@ private:
     QVector<DatabaseRecordInfoEntry> m_recordInfoEntries;
 
     QString m_why;
+
+    //record list as stored in the file
+    QByteArray recordInfoList() const;
 };
 
 #endif /* BLACK_MILORD_DATABASE_HEADER_H */
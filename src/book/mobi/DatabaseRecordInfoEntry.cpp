@@ -22,6 +22,12 @@
 #include "DatabaseRecordInfoEntry.h"
 #include <QDebug>
 
+const HeaderField<DatabaseRecordInfoEntry> DatabaseRecordInfoEntry::FIELDS[3] = {
+    HEADER_FIELD_32(DatabaseRecordInfoEntry, m_recordDataOffset),
+    HEADER_FIELD_8(DatabaseRecordInfoEntry, m_recordAttributes),
+    HEADER_FIELD_24(DatabaseRecordInfoEntry, m_uniqueID)
+};
+
 DatabaseRecordInfoEntry::DatabaseRecordInfoEntry() :
     m_recordDataOffset(0),
     m_recordAttributes(0),
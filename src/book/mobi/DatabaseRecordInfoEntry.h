@@ -23,6 +23,7 @@
 #define BLACK_MILORD_DATABASE_RECORD_INFO_ENTRY_H
 
 #include <QtGlobal>
+#include "HeaderLayout.h"
 
 class DatabaseRecordInfoEntry
 {
@@ -46,6 +47,9 @@ public:
     quint32 m_uniqueID;
 
     quint32 m_length;
+
+    //layout of the entry in the record list, m_length is not stored
+    static const HeaderField<DatabaseRecordInfoEntry> FIELDS[3];
 };
 
 
@@ -23,10 +23,13 @@
 #include <QDebug>
 #include <QString>
 #include <QDataStream>
+#include <QBuffer>
 
 const QString EXTHHeader::EXTH_MOBI_HEADER_INDENTIFIER("EXTH");
 
-EXTHHeader::EXTHHeader()
+EXTHHeader::EXTHHeader() :
+    m_headerLength(0),
+    m_recordCount(0)
 {
     memset(m_identifier, 0, EXTH_MOBI_HEADER_INDENTIFIER_SIZE+1);
 }
@@ -38,8 +41,8 @@ EXTHHeader::~EXTHHeader()
 void EXTHHeader::initForWrite()
 {
     memcpy(m_identifier, EXTH_MOBI_HEADER_INDENTIFIER.toAscii().data(), EXTH_MOBI_HEADER_INDENTIFIER.toAscii().size());
-    m_recordCount = 0;
-    m_records.clear();
+    //records read from the file are kept, known ones are updated by setters
+    m_recordCount = m_records.size();
     m_headerLength = recalculateSize();
 }
 
@@ -53,11 +56,24 @@ bool EXTHHeader::read(QDataStream &data)
     data >> m_headerLength;
     data >> m_recordCount;
 
+    m_records.clear();
+    m_index.clear();
+    //every record takes at least its 8 bytes header
+    if (data.status() != QDataStream::Ok || m_headerLength < HEADER_SIZE ||
+        m_recordCount > (m_headerLength - HEADER_SIZE) / EXTHHeaderEntry::HEADER_SIZE)
+    {
+        m_why = QObject::tr("Invalid EXTH header.");
+        return false;
+    }
     for (quint32 i=0; i<m_recordCount; ++i) {
         EXTHHeaderEntry entry;
-        entry.read(data);
+        if (!entry.read(data)) {
+            m_why = QObject::tr("Invalid EXTH record.");
+            return false;
+        }
         m_records.push_back(entry);
     }
+    rebuildIndex();
 
     print();
 
@@ -99,7 +115,7 @@ quint32 EXTHHeader::size() const
 
 quint32 EXTHHeader::recalculateSize() const
 {
-    quint32 headerLength = 12;
+    quint32 headerLength = HEADER_SIZE;
     for (int i = 0; i < m_records.size(); ++i) {
         headerLength += m_records[i].getLength();
     }
@@ -109,56 +125,156 @@ quint32 EXTHHeader::recalculateSize() const
     return headerLength;
 }
 
+void EXTHHeader::rebuildIndex()
+{
+    m_index.clear();
+    for (int i = m_records.size() - 1; i >= 0; --i) {
+        m_index.insert(m_records[i].getType(), i);
+    }
+}
+
+const EXTHHeaderEntry* EXTHHeader::findRecord(quint32 type) const
+{
+    QHash<quint32, int>::const_iterator it = m_index.constFind(type);
+    return it == m_index.constEnd() ? NULL : &m_records[it.value()];
+}
+
 bool EXTHHeader::hasRecord(quint32 type) const
 {
-    RecordListConstIterator it = m_records.begin();
-    for(; it != m_records.end(); ++it) {
-        if (it->getType() == type) {
-            return true;
-        }
+    return m_index.contains(type);
+}
+
+QString EXTHHeader::getString(quint32 type) const
+{
+    const EXTHHeaderEntry *entry = findRecord(type);
+    return entry ? entry->getValue() : QString();
+}
+
+void EXTHHeader::setString(quint32 type, const QString &value)
+{
+    if (value.isEmpty()) {
+        removeRecord(type);
+        return;
+    }
+    //record may be stored in other encoding than written, keep its original bytes
+    if (hasRecord(type) && getString(type) == value) {
+        return;
     }
-    return false;
+    EXTHHeaderEntry entry;
+    entry.setType(type);
+    entry.setValue(value);
+    storeRecord(entry);
 }
 
-EXTHHeaderEntry EXTHHeader::getRecord(quint32 type) const
+bool EXTHHeader::getNumber(quint32 type, quint32 &value) const
 {
-    RecordListConstIterator it = m_records.begin();
-    for(; it != m_records.end(); ++it) {
-        if (it->getType() == type) {
-            return *it;
-        }
+    const EXTHHeaderEntry *entry = findRecord(type);
+    if (!entry) {
+        return false;
     }
-    Q_ASSERT(false);
-    return EXTHHeaderEntry();
+    value = entry->getNumber();
+    return true;
 }
 
-EXTHHeaderEntry EXTHHeader::createRecord(quint32 type) const
+void EXTHHeader::setNumber(quint32 type, quint32 value)
 {
-    EXTHHeaderEntry result;
-    result.setType(type);
-    return result;
+    EXTHHeaderEntry entry;
+    entry.setType(type);
+    entry.setNumber(value);
+    storeRecord(entry);
 }
 
-void EXTHHeader::storeRecord(EXTHHeaderEntry &entry)
+void EXTHHeader::storeRecord(const EXTHHeaderEntry &entry)
 {
-    removeRecord(entry.getType());
-    m_records.push_back(entry);
+    QHash<quint32, int>::const_iterator it = m_index.constFind(entry.getType());
+    if (it == m_index.constEnd()) {
+        m_index.insert(entry.getType(), m_records.size());
+        m_records.push_back(entry);
+    }
+    else if (m_records[it.value()].getData() != entry.getData()) {
+        //first record of the type is replaced in place, further ones are left as they are
+        m_records[it.value()] = entry;
+    }
+    else {
+        return;
+    }
     m_recordCount = m_records.size();
-    //FIXME: called second time (first time in removeRecord
     m_headerLength = recalculateSize();
 }
 
 void EXTHHeader::removeRecord(quint32 type)
 {
-    RecordListIterator it = m_records.begin();
-    for(; it != m_records.end(); ++it) {
-        if (it->getType() == type) {
-            m_records.erase(it);
-            m_recordCount = m_records.size();
-            m_headerLength = recalculateSize();
-            return;
+    QHash<quint32, int>::const_iterator it = m_index.constFind(type);
+    if (it == m_index.constEnd()) {
+        return;
+    }
+    m_records.remove(it.value());
+    rebuildIndex();
+    m_recordCount = m_records.size();
+    m_headerLength = recalculateSize();
+}
+
+bool EXTHHeader::isLayoutRecord(quint32 type)
+{
+    switch (type) {
+    case EXTH_RECORD_TYPE_KF8_BOUNDARY_OFFSET:
+    case EXTH_RECORD_TYPE_KF8_RESOURCE_COUNT:
+    case EXTH_RECORD_TYPE_KF8_COVER_URI:
+    case EXTH_RECORD_TYPE_COVER_OFFSET:
+    case EXTH_RECORD_TYPE_THUMBNAIL_OFFSET:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void EXTHHeader::removeLayoutRecords()
+{
+    RecordList records;
+    for (int i = 0; i < m_records.size(); ++i) {
+        if (!isLayoutRecord(m_records[i].getType())) {
+            records.push_back(m_records[i]);
         }
     }
+    m_records = records;
+    rebuildIndex();
+    m_recordCount = m_records.size();
+    m_headerLength = recalculateSize();
+}
+
+QByteArray EXTHHeader::getRawRecords() const
+{
+    QByteArray records;
+    QBuffer buffer(&records);
+    buffer.open(QIODevice::WriteOnly);
+    QDataStream data(&buffer);
+    for (int i = 0; i < m_records.size(); ++i) {
+        EXTHHeaderEntry entry = m_records[i];
+        entry.write(data);
+    }
+    return records;
+}
+
+bool EXTHHeader::setRawRecords(const QByteArray &records)
+{
+    QBuffer buffer;
+    buffer.setData(records);
+    buffer.open(QIODevice::ReadOnly);
+    QDataStream data(&buffer);
+    RecordList list;
+    while (!data.atEnd()) {
+        EXTHHeaderEntry entry;
+        if (!entry.read(data)) {
+            m_why = QObject::tr("Invalid EXTH record.");
+            return false;
+        }
+        list.push_back(entry);
+    }
+    m_records = list;
+    rebuildIndex();
+    m_recordCount = m_records.size();
+    m_headerLength = recalculateSize();
+    return true;
 }
 
 QString EXTHHeader::getIdentifier() const
@@ -178,95 +294,66 @@ quint32 EXTHHeader::getRecordCount() const
 
 void EXTHHeader::setAuthor(const QString &author)
 {
-    if (author.isEmpty()) {
-        removeRecord(EXTH_RECORD_TYPE_AUTHOR);
-        return;
-    }
-    EXTHHeaderEntry entry = createRecord(EXTH_RECORD_TYPE_AUTHOR);
-    entry.setValue(author);
-    storeRecord(entry);
+    setString(EXTH_RECORD_TYPE_AUTHOR, author);
 }
 
 QString EXTHHeader::getAuthor() const
 {
-    if (hasRecord(EXTH_RECORD_TYPE_AUTHOR)) {
-        return getRecord(EXTH_RECORD_TYPE_AUTHOR).getValue();
-    }
-    return QString();
+    return getString(EXTH_RECORD_TYPE_AUTHOR);
 }
 
 void EXTHHeader::setPublisher(const QString &publisher)
 {
-    if (publisher.isEmpty()) {
-        removeRecord(EXTH_RECORD_TYPE_PUBLISHER);
-        return;
-    }
-    EXTHHeaderEntry entry = createRecord(EXTH_RECORD_TYPE_PUBLISHER);
-    entry.setValue(publisher);
-    storeRecord(entry);
+    setString(EXTH_RECORD_TYPE_PUBLISHER, publisher);
 }
 
 QString EXTHHeader::getPublisher() const
 {
-    if (hasRecord(EXTH_RECORD_TYPE_PUBLISHER)) {
-        return getRecord(EXTH_RECORD_TYPE_PUBLISHER).getValue();
-    }
-    return QString();
+    return getString(EXTH_RECORD_TYPE_PUBLISHER);
 }
 
 void EXTHHeader::setDescription(const QString &description)
 {
-    if (description.isEmpty()) {
-        removeRecord(EXTH_RECORD_TYPE_DESCRIPTION);
-        return;
-    }
-    EXTHHeaderEntry entry = createRecord(EXTH_RECORD_TYPE_DESCRIPTION);
-    entry.setValue(description);
-    storeRecord(entry);
+    setString(EXTH_RECORD_TYPE_DESCRIPTION, description);
 }
 
 QString EXTHHeader::getDescription() const
 {
-    if (hasRecord(EXTH_RECORD_TYPE_DESCRIPTION)) {
-        return getRecord(EXTH_RECORD_TYPE_DESCRIPTION).getValue();
-    }
-    return QString();
+    return getString(EXTH_RECORD_TYPE_DESCRIPTION);
 }
 
 void EXTHHeader::setSubject(const QString &subject)
 {
-    if (subject.isEmpty()) {
-        removeRecord(EXTH_RECORD_TYPE_SUBJECT);
-        return;
-    }
-    EXTHHeaderEntry entry = createRecord(EXTH_RECORD_TYPE_SUBJECT);
-    entry.setValue(subject);
-    storeRecord(entry);
+    setString(EXTH_RECORD_TYPE_SUBJECT, subject);
 }
 
 QString EXTHHeader::getSubject() const
 {
-    if (hasRecord(EXTH_RECORD_TYPE_SUBJECT)) {
-        return getRecord(EXTH_RECORD_TYPE_SUBJECT).getValue();
-    }
-    return QString();
+    return getString(EXTH_RECORD_TYPE_SUBJECT);
+}
+
+void EXTHHeader::setLanguage(const QString &language)
+{
+    setString(EXTH_RECORD_TYPE_LANGUAGE, language);
+}
+
+QString EXTHHeader::getLanguage() const
+{
+    return getString(EXTH_RECORD_TYPE_LANGUAGE);
 }
 
 void EXTHHeader::setIsbn(const QString &ISBN)
 {
-    if (ISBN.isEmpty()) {
-        removeRecord(EXTH_RECORD_TYPE_ISBN);
-        return;
-    }
-    EXTHHeaderEntry entry = createRecord(EXTH_RECORD_TYPE_ISBN);
-    entry.setValue(ISBN);
-    storeRecord(entry);
+    setString(EXTH_RECORD_TYPE_ISBN, ISBN);
 }
 
 QString EXTHHeader::getIsbn() const
 {
-    if (hasRecord(EXTH_RECORD_TYPE_ISBN)) {
-        return getRecord(EXTH_RECORD_TYPE_ISBN).getValue();
-    }
-    return QString();
+    return getString(EXTH_RECORD_TYPE_ISBN);
+}
+
+bool EXTHHeader::getCoverOffset(quint32 &offset) const
+{
+    //0xFFFFFFFF is used by some generators for books without cover
+    return getNumber(EXTH_RECORD_TYPE_COVER_OFFSET, offset) && offset != 0xFFFFFFFF;
 }
@@ -27,6 +27,7 @@ class QDataStream;
 
 #include <QtGlobal>
 #include <QVector>
+#include <QHash>
 #include <QString>
 #include "EXTHHeaderEntry.h"
 
@@ -34,14 +35,31 @@ class EXTHHeader
 {
     static const QString EXTH_MOBI_HEADER_INDENTIFIER;
     static const int EXTH_MOBI_HEADER_INDENTIFIER_SIZE = 4;
+    //identifier, header length and record count
+    static const quint32 HEADER_SIZE = 12;
 public:
 
     enum ExthRecordType {
         EXTH_RECORD_TYPE_AUTHOR = 100,
         EXTH_RECORD_TYPE_PUBLISHER = 101,
+        EXTH_RECORD_TYPE_IMPRINT = 102,
         EXTH_RECORD_TYPE_DESCRIPTION = 103,
         EXTH_RECORD_TYPE_ISBN = 104,
-        EXTH_RECORD_TYPE_SUBJECT = 105
+        EXTH_RECORD_TYPE_SUBJECT = 105,
+        EXTH_RECORD_TYPE_PUBLISHING_DATE = 106,
+        EXTH_RECORD_TYPE_REVIEW = 107,
+        EXTH_RECORD_TYPE_CONTRIBUTOR = 108,
+        EXTH_RECORD_TYPE_RIGHTS = 109,
+        EXTH_RECORD_TYPE_ASIN = 113,
+        EXTH_RECORD_TYPE_KF8_BOUNDARY_OFFSET = 121,
+        EXTH_RECORD_TYPE_KF8_RESOURCE_COUNT = 125,
+        EXTH_RECORD_TYPE_KF8_COVER_URI = 129,
+        EXTH_RECORD_TYPE_COVER_OFFSET = 201,
+        EXTH_RECORD_TYPE_THUMBNAIL_OFFSET = 202,
+        EXTH_RECORD_TYPE_CREATOR_SOFTWARE = 204,
+        EXTH_RECORD_TYPE_CDE_TYPE = 501,
+        EXTH_RECORD_TYPE_UPDATED_TITLE = 503,
+        EXTH_RECORD_TYPE_LANGUAGE = 524
     };
 
     EXTHHeader();
@@ -72,9 +90,33 @@ public:
     void setSubject(const QString &subject);
     QString getSubject() const;
 
+    void setLanguage(const QString &language);
+    QString getLanguage() const;
+
     void setIsbn(const QString &ISBN);
     QString getIsbn() const;
 
+    //index of the cover among image records, false when the book has no cover
+    bool getCoverOffset(quint32 &offset) const;
+
+    /**
+     * Access to records of any type. Records are kept in their original order
+     * and unknown ones are written back unchanged.
+     * Setting a value equal to the current one leaves the record untouched.
+     */
+    bool hasRecord(quint32 type) const;
+    QString getString(quint32 type) const;
+    void setString(quint32 type, const QString &value);
+    bool getNumber(quint32 type, quint32 &value) const;
+    void setNumber(quint32 type, quint32 value);
+    void removeRecord(quint32 type);
+    //removes all records pointing to other records of the file, they are invalid after saving
+    void removeLayoutRecords();
+
+    //all records serialized as in the file, used to carry them from reading to writing
+    QByteArray getRawRecords() const;
+    bool setRawRecords(const QByteArray &records);
+
 private:
     typedef QVector<EXTHHeaderEntry> RecordList;
     typedef RecordList::iterator RecordListIterator;
@@ -84,15 +126,16 @@ private:
     quint32 m_headerLength;
     quint32 m_recordCount;
     RecordList m_records;
+    //position of the first record of every type in m_records
+    QHash<quint32, int> m_index;
 
     QString m_why;
 
     quint32 recalculateSize() const;
-    bool hasRecord(quint32 type) const;
-    EXTHHeaderEntry getRecord(quint32 type) const;
-    EXTHHeaderEntry createRecord(quint32 type) const;
-    void storeRecord(EXTHHeaderEntry &entry);
-    void removeRecord(quint32 type);
+    void rebuildIndex();
+    const EXTHHeaderEntry* findRecord(quint32 type) const;
+    void storeRecord(const EXTHHeaderEntry &entry);
+    static bool isLayoutRecord(quint32 type);
 
 };
 
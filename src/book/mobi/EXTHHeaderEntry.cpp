@@ -21,43 +21,32 @@
 
 #include "EXTHHeaderEntry.h"
 #include <QDataStream>
+#include <QIODevice>
 #include <QDebug>
 
 EXTHHeaderEntry::EXTHHeaderEntry() :
     m_recordType(0),
-    m_recordLength(8),
-    m_data(NULL)
+    m_recordLength(HEADER_SIZE)
 {
 }
 
-EXTHHeaderEntry::EXTHHeaderEntry(const EXTHHeaderEntry &entry) :
-    m_recordType(entry.m_recordType),
-    m_recordLength(entry.m_recordLength)
-{
-    m_data = new char[m_recordLength-8];
-    memcpy(m_data, entry.m_data, m_recordLength-8);
-}
-
-EXTHHeaderEntry& EXTHHeaderEntry::operator=(const EXTHHeaderEntry &entry)
-{
-    m_recordType = entry.m_recordType;
-    m_recordLength = entry.m_recordLength;
-    m_data = new char[m_recordLength-8];
-    memcpy(m_data, entry.m_data, m_recordLength-8);
-    return *this;
-}
-
 EXTHHeaderEntry::~EXTHHeaderEntry()
 {
-    delete [] m_data;
 }
 
 bool EXTHHeaderEntry::read(QDataStream &data)
 {
     data >> m_recordType;
     data >> m_recordLength;
-    m_data = new char[m_recordLength-8];
-    data.readRawData(m_data, m_recordLength-8);
+    if (data.status() != QDataStream::Ok || m_recordLength < HEADER_SIZE ||
+        m_recordLength - HEADER_SIZE > data.device()->bytesAvailable())
+    {
+        return false;
+    }
+    m_data.resize(m_recordLength - HEADER_SIZE);
+    if (data.readRawData(m_data.data(), m_data.size()) != m_data.size()) {
+        return false;
+    }
 
     print();
 
@@ -68,7 +57,7 @@ bool EXTHHeaderEntry::write(QDataStream &data)
 {
     data << m_recordType;
     data << m_recordLength;
-    data.writeRawData(m_data, m_recordLength-8);
+    data.writeRawData(m_data.constData(), m_data.size());
     return true;
 }
 
@@ -100,14 +89,40 @@ void EXTHHeaderEntry::setLength(quint32 length)
 
 void EXTHHeaderEntry::setValue(const QString &value)
 {
-    Q_ASSERT(m_data == NULL);
-    int size = value.toUtf8().size();
-    m_data = new char[size];
-    memcpy(m_data, value.toUtf8().data(), size);
-    m_recordLength = 8 + size;
+    setData(value.toUtf8());
 }
 
 QString EXTHHeaderEntry::getValue() const
 {
-    return QString::fromUtf8(m_data, m_recordLength - 8);
-}
\ No newline at end of file
+    return QString::fromUtf8(m_data.constData(), m_data.size());
+}
+
+void EXTHHeaderEntry::setNumber(quint32 value)
+{
+    QByteArray data(4, 0);
+    data[0] = static_cast<char>(value >> 24 & 0xFF);
+    data[1] = static_cast<char>(value >> 16 & 0xFF);
+    data[2] = static_cast<char>(value >> 8 & 0xFF);
+    data[3] = static_cast<char>(value & 0xFF);
+    setData(data);
+}
+
+quint32 EXTHHeaderEntry::getNumber() const
+{
+    quint32 value = 0;
+    for (int i = 0; i < m_data.size() && i < 4; ++i) {
+        value = value << 8 | static_cast<quint8>(m_data[i]);
+    }
+    return value;
+}
+
+void EXTHHeaderEntry::setData(const QByteArray &data)
+{
+    m_data = data;
+    m_recordLength = HEADER_SIZE + data.size();
+}
+
+QByteArray EXTHHeaderEntry::getData() const
+{
+    return m_data;
+}
@@ -23,13 +23,21 @@
 #define BLACK_MILORD_EXTH_HEADER_ENTRY_H
 
 #include <QtGlobal>
+#include <QByteArray>
 
+class QDataStream;
+class QString;
+
+/**
+ * Single EXTH record, data is kept exactly as read unless it is set again.
+ */
 class EXTHHeaderEntry
 {
 public:
+    //type and length fields
+    static const quint32 HEADER_SIZE = 8;
+
     EXTHHeaderEntry();
-    EXTHHeaderEntry(const EXTHHeaderEntry &entry);
-    EXTHHeaderEntry& operator=(const EXTHHeaderEntry &entry);
     ~EXTHHeaderEntry();
     bool read(QDataStream &data);
     bool write(QDataStream &data);
@@ -44,10 +52,17 @@ public:
     void setValue(const QString &value);
     QString getValue() const;
 
+    //numeric records hold a big endian integer
+    void setNumber(quint32 value);
+    quint32 getNumber() const;
+
+    void setData(const QByteArray &data);
+    QByteArray getData() const;
+
 private:
     quint32 m_recordType;
     quint32 m_recordLength;
-    char *m_data;
+    QByteArray m_data;
 };
 
 #endif /* BLACK_MILORD_EXTH_HEADER_ENTRY_H */
@@ -0,0 +1,124 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_HEADER_LAYOUT_H
+#define BLACK_MILORD_HEADER_LAYOUT_H
+
+#include <QtGlobal>
+#include <QtEndian>
+#include <string.h>
+
+/**
+ * One field of a big endian header, headers describe their layout by a static
+ * array of fields in file order. The whole header is then converted in one pass
+ * over a memory block instead of streaming it field by field.
+ * Fields are 1 to 4 bytes long, 3 bytes fields are stored in quint32 members.
+ * Field without a member is padding, it is skipped on read and zeroed on write.
+ */
+template <class Header>
+struct HeaderField
+{
+    int size;
+    quint8 Header::*value8;
+    quint16 Header::*value16;
+    quint32 Header::*value32;
+};
+
+#define HEADER_FIELD_8(Header, member) { 1, &Header::member, 0, 0 }
+#define HEADER_FIELD_16(Header, member) { 2, 0, &Header::member, 0 }
+#define HEADER_FIELD_24(Header, member) { 3, 0, 0, &Header::member }
+#define HEADER_FIELD_32(Header, member) { 4, 0, 0, &Header::member }
+#define HEADER_PADDING(Header, bytes) { bytes, 0, 0, 0 }
+
+namespace HeaderLayout
+{
+
+template <class Header, int N>
+int size(const HeaderField<Header> (&fields)[N])
+{
+    int result = 0;
+    for (int i = 0; i < N; ++i) {
+        result += fields[i].size;
+    }
+    return result;
+}
+
+/**
+ * Reads fields which are completely inside the block, following fields keep their values.
+ * @return number of bytes taken by the read fields.
+ */
+template <class Header, int N>
+int read(Header &header, const HeaderField<Header> (&fields)[N], const char *block, int length)
+{
+    const uchar *data = reinterpret_cast<const uchar*>(block);
+    int position = 0;
+    for (int i = 0; i < N && position + fields[i].size <= length; ++i) {
+        const HeaderField<Header> &field = fields[i];
+        if (field.value8) {
+            header.*field.value8 = data[position];
+        }
+        else if (field.value16) {
+            header.*field.value16 = qFromBigEndian<quint16>(data + position);
+        }
+        else if (field.value32 && field.size == 3) {
+            header.*field.value32 = (data[position] << 16) | (data[position + 1] << 8) | data[position + 2];
+        }
+        else if (field.value32) {
+            header.*field.value32 = qFromBigEndian<quint32>(data + position);
+        }
+        position += field.size;
+    }
+    return position;
+}
+
+//writes all fields, block has to hold size(fields) bytes
+template <class Header, int N>
+void write(const Header &header, const HeaderField<Header> (&fields)[N], char *block)
+{
+    uchar *data = reinterpret_cast<uchar*>(block);
+    int position = 0;
+    for (int i = 0; i < N; ++i) {
+        const HeaderField<Header> &field = fields[i];
+        if (field.value8) {
+            data[position] = header.*field.value8;
+        }
+        else if (field.value16) {
+            qToBigEndian<quint16>(header.*field.value16, data + position);
+        }
+        else if (field.value32 && field.size == 3) {
+            const quint32 value = header.*field.value32;
+            data[position] = (value >> 16) & 0xFF;
+            data[position + 1] = (value >> 8) & 0xFF;
+            data[position + 2] = value & 0xFF;
+        }
+        else if (field.value32) {
+            qToBigEndian<quint32>(header.*field.value32, data + position);
+        }
+        else {
+            memset(data + position, 0, field.size);
+        }
+        position += field.size;
+    }
+}
+
+}
+
+#endif /* BLACK_MILORD_HEADER_LAYOUT_H */
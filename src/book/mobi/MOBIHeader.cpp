@@ -23,9 +23,65 @@
 #include <QDebug>
 #include <QString>
 #include <QDataStream>
+#include <QIODevice>
+#include <QByteArray>
 
 const QString MOBIHeader::MOBI_HEADER_INDENTIFIER("MOBI");
 
+const HeaderField<MOBIHeader> MOBIHeader::FIELDS[50] = {
+    HEADER_FIELD_32(MOBIHeader, m_mobiType),
+    HEADER_FIELD_32(MOBIHeader, m_textEncoding),
+    HEADER_FIELD_32(MOBIHeader, m_uniqueID),
+    HEADER_FIELD_32(MOBIHeader, m_fileVersion),
+    HEADER_FIELD_32(MOBIHeader, m_ortographicIndex),
+    HEADER_FIELD_32(MOBIHeader, m_inflectionIndex),
+    HEADER_FIELD_32(MOBIHeader, m_indexNames),
+    HEADER_FIELD_32(MOBIHeader, m_indexKeys),
+    HEADER_FIELD_32(MOBIHeader, m_extraIndex0),
+    HEADER_FIELD_32(MOBIHeader, m_extraIndex1),
+    HEADER_FIELD_32(MOBIHeader, m_extraIndex2),
+    HEADER_FIELD_32(MOBIHeader, m_extraIndex3),
+    HEADER_FIELD_32(MOBIHeader, m_extraIndex4),
+    HEADER_FIELD_32(MOBIHeader, m_extraIndex5),
+    HEADER_FIELD_32(MOBIHeader, m_firstNonTextRecordIndex),
+    HEADER_FIELD_32(MOBIHeader, m_fullNameOffset),
+    HEADER_FIELD_32(MOBIHeader, m_fullNameLength),
+    HEADER_FIELD_32(MOBIHeader, m_locale),
+    HEADER_FIELD_32(MOBIHeader, m_inputLanguage),
+    HEADER_FIELD_32(MOBIHeader, m_outputLanguage),
+    HEADER_FIELD_32(MOBIHeader, m_minVersion),
+    HEADER_FIELD_32(MOBIHeader, m_firstImageRecordIndex),
+    HEADER_FIELD_32(MOBIHeader, m_huffmanRecordOffset),
+    HEADER_FIELD_32(MOBIHeader, m_huffmanRecordCount),
+    HEADER_FIELD_32(MOBIHeader, m_huffmanTableOffset),
+    HEADER_FIELD_32(MOBIHeader, m_huffmanTableLength),
+    HEADER_FIELD_32(MOBIHeader, m_EXTHflags),
+    //unknown data, 32 bytes
+    HEADER_PADDING(MOBIHeader, 32),
+    HEADER_FIELD_32(MOBIHeader, m_DRMOffset),
+    HEADER_FIELD_32(MOBIHeader, m_DRMCount),
+    HEADER_FIELD_32(MOBIHeader, m_DRMSize),
+    HEADER_FIELD_32(MOBIHeader, m_DRMFlags),
+    HEADER_FIELD_32(MOBIHeader, m_unknown1),
+    HEADER_FIELD_32(MOBIHeader, m_unknown2),
+    HEADER_FIELD_32(MOBIHeader, m_unknown3),
+    HEADER_FIELD_16(MOBIHeader, m_firstContentRecord),
+    HEADER_FIELD_16(MOBIHeader, m_lastContentRecord),
+    HEADER_FIELD_32(MOBIHeader, m_unknown4),
+    HEADER_FIELD_32(MOBIHeader, m_fcisRecordIndex),
+    HEADER_FIELD_32(MOBIHeader, m_fcisRecordCount),
+    HEADER_FIELD_32(MOBIHeader, m_flisRecordIndex),
+    HEADER_FIELD_32(MOBIHeader, m_flisRecordCount),
+    HEADER_FIELD_32(MOBIHeader, m_unknown5),
+    HEADER_FIELD_32(MOBIHeader, m_unknown6),
+    HEADER_FIELD_32(MOBIHeader, m_unknown7),
+    HEADER_FIELD_32(MOBIHeader, m_unknown8),
+    HEADER_FIELD_32(MOBIHeader, m_unknown9),
+    HEADER_FIELD_32(MOBIHeader, m_unknown10),
+    HEADER_FIELD_32(MOBIHeader, m_extraDataFlags),
+    HEADER_FIELD_32(MOBIHeader, m_indexRecordOffset)
+};
+
 MOBIHeader::MOBIHeader()
 {
     memset(m_identifier, 0, MOBI_HEADER_INDENTIFIER_SIZE+1);
@@ -105,78 +161,32 @@ void MOBIHeader::initForRead()
 
 bool MOBIHeader::read(QDataStream &data)
 {
-
-#define READ_IF_AVAILABLE(variable)        \
-    data >> variable;                      \
-    readLength += sizeof(variable);        \
-    if (readLength == m_headerLength) {    \
-        goto readDone;                     \
-    }                                      \
-    Q_ASSERT(readLength < m_headerLength);
-
     initForRead();
 
     quint32 readLength = 8; //"MOBI" + header length
     data.readRawData(m_identifier, MOBI_HEADER_INDENTIFIER_SIZE);
     data >> m_headerLength;
-    READ_IF_AVAILABLE(m_mobiType)
-    READ_IF_AVAILABLE(m_textEncoding)
-    READ_IF_AVAILABLE(m_uniqueID)
-    READ_IF_AVAILABLE(m_fileVersion)
-    READ_IF_AVAILABLE(m_ortographicIndex)
-    READ_IF_AVAILABLE(m_inflectionIndex)
-    READ_IF_AVAILABLE(m_indexNames)
-    READ_IF_AVAILABLE(m_indexKeys)
-    READ_IF_AVAILABLE(m_extraIndex0)
-    READ_IF_AVAILABLE(m_extraIndex1)
-    READ_IF_AVAILABLE(m_extraIndex2)
-    READ_IF_AVAILABLE(m_extraIndex3)
-    READ_IF_AVAILABLE(m_extraIndex4)
-    READ_IF_AVAILABLE(m_extraIndex5)
-    READ_IF_AVAILABLE(m_firstNonTextRecordIndex)
-    READ_IF_AVAILABLE(m_fullNameOffset)
-    READ_IF_AVAILABLE(m_fullNameLength)
-    READ_IF_AVAILABLE(m_locale)
-    READ_IF_AVAILABLE(m_inputLanguage)
-    READ_IF_AVAILABLE(m_outputLanguage)
-    READ_IF_AVAILABLE(m_minVersion)
-    READ_IF_AVAILABLE(m_firstImageRecordIndex)
-    READ_IF_AVAILABLE(m_huffmanRecordOffset)
-    READ_IF_AVAILABLE(m_huffmanRecordCount)
-    READ_IF_AVAILABLE(m_huffmanTableOffset)
-    READ_IF_AVAILABLE(m_huffmanTableLength)
-    READ_IF_AVAILABLE(m_EXTHflags)
-    //Unknown data here, skip it
-    data.device()->seek(data.device()->pos() + 32);
-    readLength += 32;
-    READ_IF_AVAILABLE(m_DRMOffset)
-    READ_IF_AVAILABLE(m_DRMCount)
-    READ_IF_AVAILABLE(m_DRMSize)
-    READ_IF_AVAILABLE(m_DRMFlags)
-    READ_IF_AVAILABLE(m_unknown1)
-    READ_IF_AVAILABLE(m_unknown2)
-    READ_IF_AVAILABLE(m_unknown3)
-    READ_IF_AVAILABLE(m_firstContentRecord)
-    READ_IF_AVAILABLE(m_lastContentRecord)
-    READ_IF_AVAILABLE(m_unknown4)
-    READ_IF_AVAILABLE(m_fcisRecordIndex)
-    READ_IF_AVAILABLE(m_fcisRecordCount)
-    READ_IF_AVAILABLE(m_flisRecordIndex)
-    READ_IF_AVAILABLE(m_flisRecordCount)
-    READ_IF_AVAILABLE(m_unknown5)
-    READ_IF_AVAILABLE(m_unknown6)
-    READ_IF_AVAILABLE(m_unknown7)
-    READ_IF_AVAILABLE(m_unknown8)
-    READ_IF_AVAILABLE(m_unknown9)
-    READ_IF_AVAILABLE(m_unknown10)
-    READ_IF_AVAILABLE(m_extraDataFlags)
-    READ_IF_AVAILABLE(m_indexRecordOffset)
-
-    readDone:
+    //header has to contain at least the encoding and must not exceed the data
+    if (data.status() != QDataStream::Ok || m_headerLength < 16 ||
+        m_headerLength - readLength > data.device()->bytesAvailable())
+    {
+        m_why = QObject::tr("Missing MOBI file header.");
+        return false;
+    }
+    //fields are converted from one block, header may be longer than the fields known here
+    const QByteArray block = data.device()->read(m_headerLength - readLength);
+    readLength += HeaderLayout::read(*this, FIELDS, block.constData(), block.size());
+
 #ifndef QT_NO_DEBUG_OUTPUT
     print();
 #endif
 
+    //field crossing the end of the header means its length is corrupted
+    if (readLength < m_headerLength && readLength - 8 < static_cast<quint32>(HeaderLayout::size(FIELDS))) {
+        m_why = QObject::tr("Invalid MOBI header length.");
+        return false;
+    }
+
     if (MOBI_HEADER_INDENTIFIER != m_identifier) {
         m_why = QObject::tr("Missing MOBI file header.");
         return false;
@@ -195,66 +205,15 @@ bool MOBIHeader::read(QDataStream &data)
     }
 
     return true;
-#undef READ_IF_AVAILABLE
 }
 
 bool MOBIHeader::write(QDataStream& data)
 {
-    data.writeRawData(m_identifier, MOBI_HEADER_INDENTIFIER_SIZE);
-    data << m_headerLength;
-    data << m_mobiType;
-    data << m_textEncoding;
-    data << m_uniqueID ;
-    data << m_fileVersion;
-    data << m_ortographicIndex;
-    data << m_inflectionIndex;
-    data << m_indexNames;
-    data << m_indexKeys;
-    data << m_extraIndex0;
-    data << m_extraIndex1;
-    data << m_extraIndex2;
-    data << m_extraIndex3;
-    data << m_extraIndex4;
-    data << m_extraIndex5;
-    data << m_firstNonTextRecordIndex;
-    data << m_fullNameOffset;
-    data << m_fullNameLength;
-    data << m_locale;
-    data << m_inputLanguage;
-    data << m_outputLanguage;
-    data << m_minVersion;
-    data << m_firstImageRecordIndex;
-    data << m_huffmanRecordOffset;
-    data << m_huffmanRecordCount;
-    data << m_huffmanTableOffset;
-    data << m_huffmanTableLength;
-    data << m_EXTHflags;
-    //Unknown data here, 32 bytes
-    for (int i=0; i<32; ++i) {
-        data << static_cast<quint8>(0);
-    }
-    data << m_DRMOffset;
-    data << m_DRMCount;
-    data << m_DRMSize;
-    data << m_DRMFlags;
-    data << m_unknown1;
-    data << m_unknown2;
-    data << m_unknown3;
-    data << m_firstContentRecord;
-    data << m_lastContentRecord;
-    data << m_unknown4;
-    data << m_fcisRecordIndex;
-    data << m_fcisRecordCount;
-    data << m_flisRecordIndex;
-    data << m_flisRecordCount;
-    data << m_unknown5;
-    data << m_unknown6;
-    data << m_unknown7;
-    data << m_unknown8;
-    data << m_unknown9;
-    data << m_unknown10;
-    data << m_extraDataFlags;
-    data << m_indexRecordOffset;
+    QByteArray block(8 + HeaderLayout::size(FIELDS), 0);
+    memcpy(block.data(), m_identifier, MOBI_HEADER_INDENTIFIER_SIZE);
+    qToBigEndian<quint32>(m_headerLength, reinterpret_cast<uchar*>(block.data()) + 4);
+    HeaderLayout::write(*this, FIELDS, block.data() + 8);
+    data.writeRawData(block.constData(), block.size());
     return true;
 }
 
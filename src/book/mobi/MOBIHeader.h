@@ -24,6 +24,7 @@
 
 #include <QString>
 #include <QtGlobal>
+#include "HeaderLayout.h"
 
 class QDataStream;
 
@@ -31,6 +32,8 @@ class MOBIHeader
 {
     static const QString MOBI_HEADER_INDENTIFIER;
     static const int MOBI_HEADER_INDENTIFIER_SIZE = 4;
+    //fields following the identifier and header length
+    static const HeaderField<MOBIHeader> FIELDS[50];
 public:
 
     enum mobiType {
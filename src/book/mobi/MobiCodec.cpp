@@ -22,50 +22,131 @@
 #include "MobiCodec.h"
 #include <QDebug>
 #include <QByteArray>
+#include <QVector>
 
-QByteArray MobiCodec::DecodePalmDoc(const QByteArray &compressed)
+namespace {
+    //limits of a back reference, its distance has 11 bits and length 3 bits
+    const int MIN_MATCH = 3;
+    const int MAX_MATCH = 10;
+    const int MAX_DISTANCE = 2047;
+    const int HASH_SIZE = 4096;
+    //longer chains find slightly better matches but slow down saving
+    const int MAX_CHAIN = 64;
+
+    int hash(const quint8 *data)
+    {
+        return ((data[0] << 8) ^ (data[1] << 4) ^ data[2]) & (HASH_SIZE - 1);
+    }
+
+    //bytes which cannot be written as themselves, they are copied in counted runs
+    bool needsLiteralRun(quint8 byte)
+    {
+        return (byte >= 0x01 && byte <= 0x08) || byte >= 0x80;
+    }
+}
+
+bool MobiCodec::DecodePalmDoc(const QByteArray &compressed, QByteArray &result)
 {
-    QByteArray result;
-    QByteArray::ConstIterator it = compressed.begin();
-    for (; it != compressed.end(); ++it) {
-        if (static_cast<quint8>(*it) == 0) {
-            result.push_back(*it);
+    //back references must not reach data of previous records
+    const int recordStart = result.size();
+    const quint8 *data = reinterpret_cast<const quint8*>(compressed.constData());
+    const int size = compressed.size();
+    int i = 0;
+    while (i < size) {
+        const quint8 code = data[i++];
+        if (code == 0 || (code >= 0x09 && code <= 0x7F)) {
+            result.push_back(code);
         }
-        else if (static_cast<quint8>(*it) >= 0x01 &&
-                 static_cast<quint8>(*it) <= 0x08)
-        {
-            int count = static_cast<quint8>(*it);
-            for (int i = 0; i < count; ++i) {
-                ++it;
-                Q_ASSERT(it != compressed.end());
-                result.push_back(*it);
+        else if (code <= 0x08) {
+            //literal bytes follow
+            if (size - i < code) {
+                return false;
             }
+            result.append(reinterpret_cast<const char*>(data + i), code);
+            i += code;
         }
-        else if (static_cast<quint8>(*it) >= 0x09 &&
-                 static_cast<quint8>(*it) <= 0x7F)
-        {
-            result.push_back(*it);
-        }
-        else if (static_cast<quint8>(*it) >= 0x80 &&
-                 static_cast<quint8>(*it) <= 0xBF)
-        {
-            quint16 data = static_cast<quint8>(*it) * 256;
-            ++it;
-            Q_ASSERT(it != compressed.end());
-            data += static_cast<quint8>(*it);
-            int size = 3 + (data & 0x07);
-            int distance = (data / 8) & 0x07FF;
-            QByteArray replace = result.mid(result.size() - distance, size);
-            while (replace.size() < size) {
-                replace.append(replace);
+        else if (code <= 0xBF) {
+            if (i == size) {
+                return false;
+            }
+            const int pair = code * 256 + data[i++];
+            const int length = 3 + (pair & 0x07);
+            const int distance = (pair / 8) & 0x07FF;
+            if (distance == 0 || distance > result.size() - recordStart) {
+                return false;
+            }
+            //copied byte by byte, the repeated sequence may overlap the copy
+            const int from = result.size() - distance;
+            for (int j = 0; j < length; ++j) {
+                result.push_back(result.at(from + j));
             }
-            replace.truncate(size);
-            result.append(replace);
         }
-        else { //if (static_cast<quint8>(*it) >= 0xC0)
+        else {
             result.push_back(' ');
-            result.push_back(static_cast<quint8>(*it) ^ 0x80);
+            result.push_back(code ^ 0x80);
+        }
+    }
+    return true;
+}
+
+void MobiCodec::EncodePalmDoc(const QByteArray &data, QByteArray &result)
+{
+    const quint8 *input = reinterpret_cast<const quint8*>(data.constData());
+    const int size = data.size();
+    //earlier positions with the same hash, newest first
+    QVector<int> head(HASH_SIZE, -1);
+    QVector<int> previous(size, -1);
+    int i = 0;
+    while (i < size) {
+        int bestLength = 0;
+        int bestDistance = 0;
+        if (size - i >= MIN_MATCH) {
+            const int maxLength = qMin(MAX_MATCH, size - i);
+            int candidate = head[hash(input + i)];
+            for (int chain = 0; candidate != -1 && i - candidate <= MAX_DISTANCE && chain < MAX_CHAIN; ++chain) {
+                //the match may overlap the current position, it is decoded byte by byte
+                int length = 0;
+                while (length < maxLength && input[candidate + length] == input[i + length]) {
+                    ++length;
+                }
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = i - candidate;
+                    if (length == maxLength) {
+                        break;
+                    }
+                }
+                candidate = previous[candidate];
+            }
+        }
+
+        int consumed = 1;
+        if (bestLength >= MIN_MATCH) {
+            const int pair = 0x8000 | (bestDistance << 3) | (bestLength - MIN_MATCH);
+            result.push_back(static_cast<char>(pair >> 8));
+            result.push_back(static_cast<char>(pair & 0xFF));
+            consumed = bestLength;
+        }
+        else if (input[i] == ' ' && i + 1 < size && input[i + 1] >= 0x40 && input[i + 1] <= 0x7F) {
+            result.push_back(static_cast<char>(input[i + 1] ^ 0x80));
+            consumed = 2;
+        }
+        else if (!needsLiteralRun(input[i])) {
+            result.push_back(static_cast<char>(input[i]));
+        }
+        else {
+            while (consumed < 8 && i + consumed < size && needsLiteralRun(input[i + consumed])) {
+                ++consumed;
+            }
+            result.push_back(static_cast<char>(consumed));
+            result.append(reinterpret_cast<const char*>(input + i), consumed);
+        }
+
+        for (int j = i; j < i + consumed && j + MIN_MATCH <= size; ++j) {
+            const int key = hash(input + j);
+            previous[j] = head[key];
+            head[key] = j;
         }
+        i += consumed;
     }
-    return result;
-}
\ No newline at end of file
+}
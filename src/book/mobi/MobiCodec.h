@@ -26,7 +26,17 @@ class QByteArray;
 
 class MobiCodec {
 public:
-    static QByteArray DecodePalmDoc(const QByteArray &compressed);
+    /**
+     * Decodes one PalmDOC compressed record and appends it to result.
+     * @return false when the record is corrupted, result then holds only part of it.
+     */
+    static bool DecodePalmDoc(const QByteArray &compressed, QByteArray &result);
+
+    /**
+     * Encodes one record with PalmDOC compression and appends it to result.
+     * Back references stay within the record, as DecodePalmDoc requires.
+     */
+    static void EncodePalmDoc(const QByteArray &data, QByteArray &result);
 };
 
 #endif /*BLACK_MILORD_CODEC_H*/
\ No newline at end of file
@@ -24,19 +24,22 @@
 #include <QFile>
 #include <QDataStream>
 #include <QTextCodec>
-#include <QRegExp>
 #include <QString>
 #include <QStringList>
 #include <QIODevice>
+#include <QBuffer>
 #include <QTemporaryFile>
 #include <QDateTime>
-#include <QPixmap>
 
 #include <Book.h>
+#include <BookMetadata.h>
 #include <Dictionary.h>
 #include <Formatting.h>
 #include "DatabaseRecordInfoEntry.h"
 #include "MobiCodec.h"
+#include "TextRecordWriter.h"
+#include <PieceTable.h>
+#include <ElementIndex.h>
 
 MobiFile::MobiFile()
 {
@@ -57,49 +60,24 @@ bool MobiFile::openFile(const QString &fileName)
     }
     QDataStream data(&file);
 
-    //read Database header
-    if (!m_databaseHeader.read(data)) {
-        Book::instance().setWhy(m_databaseHeader.why());
+    QString why;
+    if (!readHeaderRecord(data, why)) {
+        Book::instance().setWhy(why);
         file.close();
         return false;
     }
 
-    //seek to first record
-    data.device()->seek(m_databaseHeader.getRecordOffset(0));
-
-    //read Palm DOC header
-    if (!m_palmDOCHeader.read(data)) {
-        Book::instance().setWhy(m_palmDOCHeader.why());
-        file.close();
-        return false;
-    }
-
-    //read MOBI header
-    if (!m_MOBIHeader.read(data)) {
-        Book::instance().setWhy(m_MOBIHeader.why());
+    //pictures are read first, references in the text depend on their deduplication
+    if (!readImageRecords(data)) {
         file.close();
         return false;
     }
 
-    //read EXTH header if exists
-    if (hasEXTH()) {
-        if (!m_EXTHHeader.read(data)) {
-            Book::instance().setWhy(m_EXTHHeader.why());
-            file.close();
-            return false;
-        }
-    }
-
     if (!readTextRecords(data)) {
         file.close();
         return false;
     }
 
-    if (!readImageRecords(data)) {
-        file.close();
-        return false;
-    }
-
     file.close();
 
     Book::instance().setMetadata(METADATA_CREATION_DATE, m_databaseHeader.getCreationDate());
@@ -111,11 +89,78 @@ bool MobiFile::openFile(const QString &fileName)
     Book::instance().setMetadata(METADATA_ISBN, m_EXTHHeader.getIsbn());
     Book::instance().setMetadata(METADATA_PUBLISHER, m_EXTHHeader.getPublisher());
     Book::instance().setMetadata(METADATA_SUBJECT, m_EXTHHeader.getSubject());
+    Book::instance().setMetadata(METADATA_LANGUAGE, m_EXTHHeader.getLanguage());
     Book::instance().setMetadata(METADATA_DESCRIPTION, m_EXTHHeader.getDescription());
+    Book::instance().setMetadata(METADATA_COVER_PICTURE, pictureIndex(EXTHHeader::EXTH_RECORD_TYPE_COVER_OFFSET));
+    Book::instance().setMetadata(METADATA_THUMBNAIL_PICTURE, pictureIndex(EXTHHeader::EXTH_RECORD_TYPE_THUMBNAIL_OFFSET));
+    //record numbers change when saving, cover and thumbnail are written back from the book
+    m_EXTHHeader.removeLayoutRecords();
+    Book::instance().setMetadata(METADATA_EXTH_RECORDS, m_EXTHHeader.getRawRecords());
 
     return true;
 }
 
+bool MobiFile::readMetadata(const QString &fileName, BookMetadata &metadata)
+{
+    metadata.fileName = fileName;
+    metadata.valid = false;
+    QFile file(fileName);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly))
+    {
+        metadata.why = tr("File cannot be opened.");
+        return false;
+    }
+    QDataStream data(&file);
+
+    if (!readHeaderRecord(data, metadata.why)) {
+        file.close();
+        return false;
+    }
+
+    //only the cover record is read, other records are not touched
+    quint32 coverOffset = 0;
+    if (m_EXTHHeader.getCoverOffset(coverOffset)) {
+        quint32 record = m_MOBIHeader.getFirstImageRecordIndex() + coverOffset;
+        //first image index is 0xFFFFFFFF in books without pictures, the sum overflows then
+        if (record > coverOffset && record < static_cast<quint32>(m_databaseHeader.getNumberOfRecords())) {
+            data.device()->seek(m_databaseHeader.getRecordOffset(record));
+            QByteArray cover = data.device()->read(m_databaseHeader.getRecordLength(record));
+            if (!BookPicture::detectFormat(cover).isEmpty()) {
+                metadata.cover = cover;
+            }
+        }
+    }
+    file.close();
+
+    metadata.values[METADATA_CREATION_DATE] = m_databaseHeader.getCreationDate();
+    metadata.values[METADATA_MODIFICATION_DATE] = m_databaseHeader.getModificationDate();
+    metadata.values[METADATA_LAST_BACKUP_DATE] = m_databaseHeader.getLastBackupDate();
+    metadata.values[METADATA_MODIFICATION_NUMBER] = m_databaseHeader.getModificationNumber();
+    metadata.values[METADATA_VERSION] = m_databaseHeader.getVersion();
+    metadata.values[METADATA_AUTHOR] = m_EXTHHeader.getAuthor();
+    metadata.values[METADATA_ISBN] = m_EXTHHeader.getIsbn();
+    metadata.values[METADATA_PUBLISHER] = m_EXTHHeader.getPublisher();
+    metadata.values[METADATA_SUBJECT] = m_EXTHHeader.getSubject();
+    metadata.values[METADATA_LANGUAGE] = m_EXTHHeader.getLanguage();
+    metadata.values[METADATA_DESCRIPTION] = m_EXTHHeader.getDescription();
+    metadata.valid = true;
+    return true;
+}
+
+bool MobiFile::readText(const QString &fileName, QString &text, QString &why)
+{
+    QFile file(fileName);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly))
+    {
+        why = tr("File cannot be opened.");
+        return false;
+    }
+    QDataStream data(&file);
+    bool result = readHeaderRecord(data, why) && decodeText(data, text, why);
+    file.close();
+    return result;
+}
+
 bool MobiFile::newFile()
 {
     return true;
@@ -147,9 +192,17 @@ bool MobiFile::saveFile(const QString &fileName)
         m_databaseHeader.initForWrite();
         m_palmDOCHeader.initForWrite();
         m_MOBIHeader.initForWrite();
+        //records of the opened file are written back, known ones are updated below
+        m_EXTHHeader.setRawRecords(Book::instance().getMetadata(METADATA_EXTH_RECORDS).toByteArray());
+        m_EXTHHeader.removeLayoutRecords();
         m_EXTHHeader.initForWrite();
 
-        QList<QByteArray> textRecords = prepareTextRecords();
+        QList<QByteArray> textRecords;
+        quint32 textLength = 0;
+        if (!prepareTextRecords(textRecords, textLength)) {
+            Book::instance().setWhy(tr("Not supported encoding."));
+            break;
+        }
         int currentRecordNumber = 0;
         QString fullName = Book::instance().getMetadata(METADATA_SUBJECT).toString();
         int fullNameSize = fullName.toUtf8().size();
@@ -159,16 +212,27 @@ bool MobiFile::saveFile(const QString &fileName)
         m_databaseHeader.setLastBackupDate(Book::instance().getMetadata(METADATA_LAST_BACKUP_DATE).toDateTime());
         m_databaseHeader.setCreationDate(Book::instance().getMetadata(METADATA_CREATION_DATE).toDateTime());
         m_databaseHeader.setModificationNumber(Book::instance().getMetadata(METADATA_MODIFICATION_NUMBER).toUInt() + 1);
-        m_databaseHeader.setNumberOfRecords(2 + textRecords.size()); //header record + text records + EOF record
+        const int pictureCount = Book::instance().getPicturesCount();
+        m_databaseHeader.setNumberOfRecords(2 + textRecords.size() + pictureCount); //header record + text records + image records + EOF record
 
-        m_palmDOCHeader.setTextLength(encodedTextSize());
+        m_palmDOCHeader.setTextLength(textLength);
         m_palmDOCHeader.setTextRecordCount(textRecords.size());
 
         m_EXTHHeader.setAuthor(Book::instance().getMetadata(METADATA_AUTHOR).toString());
         m_EXTHHeader.setIsbn(Book::instance().getMetadata(METADATA_ISBN).toString());
         m_EXTHHeader.setPublisher(Book::instance().getMetadata(METADATA_PUBLISHER).toString());
         m_EXTHHeader.setSubject(Book::instance().getMetadata(METADATA_SUBJECT).toString());
+        m_EXTHHeader.setLanguage(Book::instance().getMetadata(METADATA_LANGUAGE).toString());
         m_EXTHHeader.setDescription(Book::instance().getMetadata(METADATA_DESCRIPTION).toString());
+        //pictures are written in order, so the offset of a picture is its index
+        const int cover = Book::instance().getMetadata(METADATA_COVER_PICTURE).toInt();
+        if (cover >= 0 && cover < pictureCount) {
+            m_EXTHHeader.setNumber(EXTHHeader::EXTH_RECORD_TYPE_COVER_OFFSET, cover);
+        }
+        const int thumbnail = Book::instance().getMetadata(METADATA_THUMBNAIL_PICTURE).toInt();
+        if (thumbnail >= 0 && thumbnail < pictureCount) {
+            m_EXTHHeader.setNumber(EXTHHeader::EXTH_RECORD_TYPE_THUMBNAIL_OFFSET, thumbnail);
+        }
 
         m_MOBIHeader.setFullNameOffset(
                 m_palmDOCHeader.size() +
@@ -177,7 +241,7 @@ bool MobiFile::saveFile(const QString &fileName)
         m_MOBIHeader.setFullNameLength(fullNameSize);
         m_MOBIHeader.setFirstImageRecordIndex(1 + textRecords.size());
         m_MOBIHeader.setFirstNonTextRecordIndex(1 + textRecords.size());
-        m_MOBIHeader.setLastContentRecord(1 + textRecords.size() + Book::instance().getPicturesCount());
+        m_MOBIHeader.setLastContentRecord(1 + textRecords.size() + pictureCount);
 
         //Write Database header
         if (!m_databaseHeader.write(data)) {
@@ -221,15 +285,18 @@ bool MobiFile::saveFile(const QString &fileName)
         //here some unknown data may appear in most mobi files
 
         //Write text
-        QByteArray newData;
-        qint64 offset = data.device()->pos();
         QList<QByteArray>::ConstIterator it = textRecords.begin();
         for (; it != textRecords.end(); ++it) {
-            m_databaseHeader.setRecordOffset(currentRecordNumber++, offset);
-            offset += it->size();
-            newData.append(*it);
+            m_databaseHeader.setRecordOffset(currentRecordNumber++, data.device()->pos());
+            data.writeRawData(it->constData(), it->size());
+        }
+
+        //Write images, in order of picture indexes used by recindex attributes
+        for (int i = 0; i < pictureCount; ++i) {
+            const QByteArray &picture = Book::instance().getPicture(i).getCurrentPictureData();
+            m_databaseHeader.setRecordOffset(currentRecordNumber++, data.device()->pos());
+            data.writeRawData(picture.constData(), picture.size());
         }
-        data.writeRawData(newData.data(), newData.size());
 
         //Write EOF record
         m_databaseHeader.setRecordOffset(currentRecordNumber++, data.device()->pos());
@@ -252,120 +319,153 @@ bool MobiFile::saveFile(const QString &fileName)
     return writeOk;
 }
 
-QString MobiFile::textToWrite() const
+bool MobiFile::readHeaderRecord(QDataStream &data, QString &why)
 {
-    return Book::instance().getText().remove("\n");
+    //read Database header
+    if (!m_databaseHeader.read(data)) {
+        why = m_databaseHeader.why();
+        return false;
+    }
+
+    //headers are parsed from a copy of the first record, so they cannot read past it
+    data.device()->seek(m_databaseHeader.getRecordOffset(0));
+    QByteArray headerRecord = data.device()->read(m_databaseHeader.getRecordLength(0));
+    QBuffer buffer(&headerRecord);
+    buffer.open(QIODevice::ReadOnly);
+    QDataStream header(&buffer);
+
+    //read Palm DOC header
+    if (!m_palmDOCHeader.read(header)) {
+        why = m_palmDOCHeader.why();
+        return false;
+    }
+
+    //read MOBI header
+    if (!m_MOBIHeader.read(header)) {
+        why = m_MOBIHeader.why();
+        return false;
+    }
+
+    //read EXTH header if exists
+    if (hasEXTH()) {
+        if (!m_EXTHHeader.read(header)) {
+            why = m_EXTHHeader.why();
+            return false;
+        }
+    }
+
+    if (m_palmDOCHeader.getTextRecordCount() >= m_databaseHeader.getNumberOfRecords()) {
+        why = tr("Invalid number of text records.");
+        return false;
+    }
+    return true;
 }
 
-quint32 MobiFile::encodedTextSize() const
+QTextCodec* MobiFile::textCodec() const
 {
-    QTextCodec* codec = NULL;
     if (m_MOBIHeader.getTextEncoding() == MOBIHeader::ENCODING_UTF_8) {
-        codec = QTextCodec::codecForName("UTF-8");
+        return QTextCodec::codecForName("UTF-8");
     }
     else if (m_MOBIHeader.getTextEncoding() == MOBIHeader::ENCODING_CP1252) {
-        codec = QTextCodec::codecForName("Windows-1252");
+        return QTextCodec::codecForName("Windows-1252");
     }
-    if (NULL == codec) {
-        return 0;
-    }
-    QByteArray rawData;
-    QTextStream stream(&rawData);
-    stream.setCodec(codec);
-    stream << textToWrite();
-    stream.flush();
-    return rawData.size();
+    return NULL;
 }
 
-QList<QByteArray> MobiFile::prepareTextRecords() const
+bool MobiFile::prepareTextRecords(QList<QByteArray> &records, quint32 &textLength) const
 {
-    QList<QByteArray> textRecords;
-    QString text = textToWrite();
-
-    QTextCodec* codec = NULL;
-    if (m_MOBIHeader.getTextEncoding() == 65001) {
-        codec = QTextCodec::codecForName("UTF-8");
-    }
-    else if (m_MOBIHeader.getTextEncoding() == 1252) {
-        codec = QTextCodec::codecForName("Windows-1252");
-    }
+    QTextCodec* codec = textCodec();
     if (NULL == codec) {
-        return textRecords;
+        return false;
     }
-    QByteArray overlap;
-    int textIndex = 0;
-
-    while(textIndex < text.size()) {
-        QByteArray record;
-        QTextStream stream(&record);
-        stream.setCodec(codec);
-        while (record.size() + overlap.size() < 4096 && textIndex < text.size()) {
-            stream << text.at(textIndex++);
-            stream.flush();
-        }
-        // record cannot be initialized with overlap content
-        // stream's << operator is resetting it for some reason.
-        if (overlap.size() > 0) {
-            record.insert(0, overlap);
-        }
-        //next record has to copy overlapped bytes
-        if (textIndex == text.size() && record.size() <= 4096) {
-            record.append(static_cast<char>(0));
-            overlap.clear();
-        }
-        else {
-            overlap = record.right(record.size() - 4096);
-            record.append(static_cast<char>(record.size() - 4096));
-        }
-        textRecords.push_back(record);
+    //encode pieces of the text directly, without joining it
+    TextRecordWriter writer(codec, m_palmDOCHeader.getCompression() == PalmDOCHeader::COMPRESSION_PALMDOC);
+    const PieceTable text = Book::instance().getTextSnapshot();
+    for (int i = 0; i < text.chunkCount(); ++i) {
+        const QStringRef chunk = text.chunk(i);
+        writer.append(chunk.unicode(), chunk.length());
     }
-    return textRecords;
+    writer.finish();
+    records = writer.records();
+    textLength = writer.textLength();
+    return true;
 }
 
 bool MobiFile::readImageRecords(QDataStream &data)
 {
-    bool loaded;
-    int count = 0;
+    //images are only recognized by their headers here, they are decoded when shown or edited
+    m_pictureIndexes.clear();
+    //index is 0xFFFFFFFF in books without pictures, record 0 holds the headers
+    if (0 == m_MOBIHeader.getFirstImageRecordIndex() ||
+        m_MOBIHeader.getFirstImageRecordIndex() >= static_cast<quint32>(m_databaseHeader.getNumberOfRecords()))
+    {
+        return true;
+    }
     int record = m_MOBIHeader.getFirstImageRecordIndex();
-    do {
-        if (m_databaseHeader.getNumberOfRecords() <= record) {
-            break;
-        }
+    while (record < static_cast<int>(m_databaseHeader.getNumberOfRecords())) {
         data.device()->seek(m_databaseHeader.getRecordOffset(record));
         quint32 length = m_databaseHeader.getRecordLength(record);
         QByteArray imageData = data.device()->read(length);
         if (imageData.size() != static_cast<int>(length)) {
+            Book::instance().setWhy(tr("Invalid image record."));
             return false;
         }
-        //validate image
-        loaded = QPixmap().loadFromData(imageData);
-        if (loaded) {
-            Book::instance().addPicture(BookPicture(imageData));
-            ++count;
+        if (BookPicture::detectFormat(imageData).isEmpty()) {
+            break;
         }
+        m_pictureIndexes.append(Book::instance().addPicture(BookPicture(imageData)));
         ++record;
-    } while (loaded);
-    qDebug() << "loaded" << count << "images.";
+    }
+    qDebug() << "loaded" << m_pictureIndexes.size() << "images," << Book::instance().getPicturesCount() << "unique.";
     return true;
 }
 
+int MobiFile::pictureIndex(quint32 type) const
+{
+    quint32 offset = 0;
+    //0xFFFFFFFF used for books without cover is out of range too
+    if (m_EXTHHeader.getNumber(type, offset) && offset < static_cast<quint32>(m_pictureIndexes.size())) {
+        return m_pictureIndexes[offset];
+    }
+    return -1;
+}
+
 bool MobiFile::readTextRecords(QDataStream &data)
 {
-    QTextCodec* codec = NULL;
-    if (m_MOBIHeader.getTextEncoding() == 65001) {
-        codec = QTextCodec::codecForName("UTF-8");
+    QString content;
+    QString why;
+    if (!decodeText(data, content, why)) {
+        Book::instance().setWhy(why);
+        return false;
     }
-    else if (m_MOBIHeader.getTextEncoding() == 1252) {
-        codec = QTextCodec::codecForName("Windows-1252");
+    if (Book::instance().getPicturesCount() != m_pictureIndexes.size()) {
+        //point references of duplicated images to the stored picture
+        PieceTable pieces(content);
+        ElementIndex elements;
+        elements.reset(pieces);
+        const QVector<TextReplacement> replacements = Book::renumberPictures(elements.findAll("img"), m_pictureIndexes);
+        for (int i = replacements.size() - 1; i >= 0; --i) {
+            pieces.replace(replacements[i].position, replacements[i].length, replacements[i].after);
+        }
+        content = pieces.toString();
     }
+    Book::instance().setText(content);
+    return true;
+}
+
+bool MobiFile::decodeText(QDataStream &data, QString &content, QString &why)
+{
+    QTextCodec* codec = textCodec();
     if (NULL == codec) {
-        Book::instance().setWhy(tr("Not supported encoding."));
+        why = tr("Not supported encoding.");
         return false;
     }
     quint32 length = 0;
     qint64 overlap = 0;
     QByteArray rawData;
-    rawData.reserve(m_palmDOCHeader.getTextLength());
+    //declared length is only a hint, records cannot decode to more than their maximal size
+    rawData.reserve(qMin<quint32>(m_palmDOCHeader.getTextLength(),
+                                  m_palmDOCHeader.getTextRecordCount() * PalmDOCHeader::MAX_RECORD_SIZE));
     for (quint16 i = 1; i <= m_palmDOCHeader.getTextRecordCount(); ++i) {
         //qDebug() << "loading record" << i;
         length = m_databaseHeader.getRecordLength(i);
@@ -373,40 +473,56 @@ bool MobiFile::readTextRecords(QDataStream &data)
 
         QByteArray newData = data.device()->read(length);
 
-        //remove trailing entries
-        for (int i = 0; i < trailingEntriesCount(); ++i ) {
+        //remove trailing entries, their sizes are stored backward at the end of the record
+        bool trailingOk = true;
+        for (int i = 0; trailingOk && i < trailingEntriesCount(); ++i ) {
             int bytesRead = 0;
             int dataSize = 0;
             quint8 value = 0;
-            while (0 == (0x80 & value)) {
-                value = static_cast<quint8>(newData.right(1).at(0));
-                newData.chop(1);
-                dataSize *= 128;
-                dataSize += (0x7F & value);
-                ++bytesRead;
+            while (trailingOk && 0 == (0x80 & value)) {
+                trailingOk = !newData.isEmpty() && bytesRead < 4;
+                if (trailingOk) {
+                    value = static_cast<quint8>(newData.at(newData.size() - 1));
+                    newData.chop(1);
+                    dataSize *= 128;
+                    dataSize += (0x7F & value);
+                    ++bytesRead;
+                }
             }
+            trailingOk = trailingOk && dataSize >= bytesRead && dataSize - bytesRead <= newData.size();
             newData.chop(dataSize - bytesRead);
         }
-        if (hasOverlaps()) {
-            overlap = static_cast<quint8>(newData.right(1).at(0));
-            overlap &= 0x03;
-            newData.chop(1 + overlap);
+        if (trailingOk && hasOverlaps()) {
+            trailingOk = !newData.isEmpty();
+            if (trailingOk) {
+                overlap = static_cast<quint8>(newData.at(newData.size() - 1));
+                overlap &= 0x03;
+                trailingOk = 1 + overlap <= newData.size();
+                newData.chop(1 + overlap);
+            }
+        }
+        if (!trailingOk) {
+            why = tr("Invalid text record.");
+            return false;
         }
 
         if (m_palmDOCHeader.getCompression() == PalmDOCHeader::COMPRESSION_NONE) {
             rawData.append(newData);
         }
         else if (m_palmDOCHeader.getCompression() == PalmDOCHeader::COMPRESSION_PALMDOC) {
-            rawData.append(MobiCodec::DecodePalmDoc(newData));
+            if (!MobiCodec::DecodePalmDoc(newData, rawData)) {
+                why = tr("Invalid compressed text record.");
+                return false;
+            }
         }
         else {
-            Book::instance().setWhy(tr("Not supported compression."));
+            why = tr("Not supported compression.");
             return false;
         }
     }
     QTextStream text(rawData);
     text.setCodec(codec);
-    Book::instance().setText(Formatting::formatHTMLContent(text.readAll()));
+    content = Formatting::formatHTMLContent(text.readAll());
     return true;
 }
 
@@ -39,6 +39,7 @@
 class QDataStream;
 class QByteArray;
 class WriteState;
+class QTextCodec;
 
 class MobiFile : public QObject, public AbstractBook
 {
@@ -49,6 +50,8 @@ public:
     bool newFile();
     bool canOpenFile();
     bool canSaveFile();
+    bool readMetadata(const QString &fileName, BookMetadata &metadata);
+    bool readText(const QString &fileName, QString &text, QString &why);
 
     const DatabaseHeader& getDatabaseHeader() const;
     const PalmDOCHeader& getPalmDOCHeader() const;
@@ -62,15 +65,21 @@ private:
     PalmDOCHeader m_palmDOCHeader;
     MOBIHeader m_MOBIHeader;
     EXTHHeader m_EXTHHeader;
+    //index in Book of the picture read from every image record, duplicated images share one picture
+    QVector<int> m_pictureIndexes;
 
     MobiFile();
     virtual ~MobiFile();
 
-    QString textToWrite() const;
-    QList<QByteArray> prepareTextRecords() const;
-    quint32 encodedTextSize() const;
+    QTextCodec* textCodec() const;
+    bool prepareTextRecords(QList<QByteArray> &records, quint32 &textLength) const;
 
+    bool readHeaderRecord(QDataStream &data, QString &why);
     bool readTextRecords(QDataStream &data);
+    //index in Book of the picture an offset record points to, -1 when there is none
+    int pictureIndex(quint32 type) const;
+    //decodes and formats text records, Book is not used
+    bool decodeText(QDataStream &data, QString &content, QString &why);
     bool readImageRecords(QDataStream &data);
 
     bool hasOverlaps() const;
@@ -21,6 +21,18 @@
 
 #include "PalmDOCHeader.h"
 #include <QDebug>
+#include <QDataStream>
+#include <QByteArray>
+
+const HeaderField<PalmDOCHeader> PalmDOCHeader::FIELDS[7] = {
+    HEADER_FIELD_16(PalmDOCHeader, m_compression),
+    HEADER_PADDING(PalmDOCHeader, 2),
+    HEADER_FIELD_32(PalmDOCHeader, m_textLength),
+    HEADER_FIELD_16(PalmDOCHeader, m_textRecordCount),
+    HEADER_FIELD_16(PalmDOCHeader, m_maxRecordSize),
+    HEADER_FIELD_16(PalmDOCHeader, m_encryption),
+    HEADER_PADDING(PalmDOCHeader, 2)
+};
 
 PalmDOCHeader::PalmDOCHeader()
     : m_compression(COMPRESSION_NONE)
@@ -33,7 +45,7 @@ PalmDOCHeader::PalmDOCHeader()
 
 void PalmDOCHeader::initForWrite()
 {
-    m_compression = COMPRESSION_NONE;
+    m_compression = COMPRESSION_PALMDOC;
     m_textLength = 0;
     m_textRecordCount = 0;
     m_maxRecordSize = MAX_RECORD_SIZE;
@@ -42,18 +54,17 @@ void PalmDOCHeader::initForWrite()
 
 bool PalmDOCHeader::read(QDataStream &data)
 {
-    quint16 tmp16;
-    data >> m_compression;
-    data >> tmp16;
-    if (tmp16 != 0) {
+    QByteArray block(size(), 0);
+    if (data.readRawData(block.data(), block.size()) != block.size()) {
         m_why = QObject::tr("Invalid header.");
         return false;
     }
-    data >> m_textLength;
-    data >> m_textRecordCount;
-    data >> m_maxRecordSize;
-    data >> m_encryption;
-    data >> tmp16;
+    //2 bytes after compression are always 0
+    if (block.at(2) != 0 || block.at(3) != 0) {
+        m_why = QObject::tr("Invalid header.");
+        return false;
+    }
+    HeaderLayout::read(*this, FIELDS, block.constData(), block.size());
 
     print();
 
@@ -72,13 +83,9 @@ bool PalmDOCHeader::read(QDataStream &data)
 
 bool PalmDOCHeader::write(QDataStream& data)
 {
-    data << m_compression;
-    data << static_cast<quint16>(0);
-    data << m_textLength;
-    data << m_textRecordCount;
-    data << m_maxRecordSize;
-    data << m_encryption;
-    data << static_cast<quint16>(0);
+    QByteArray block(size(), 0);
+    HeaderLayout::write(*this, FIELDS, block.data());
+    data.writeRawData(block.constData(), block.size());
     return true;
 }
 
@@ -99,6 +106,7 @@ QString PalmDOCHeader::why() const
 
 quint32 PalmDOCHeader::size() const
 {
+    Q_ASSERT(HeaderLayout::size(FIELDS) == 16);
     return 16;
 }
 
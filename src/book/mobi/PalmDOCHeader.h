@@ -24,6 +24,7 @@
 
 #include <QtGlobal>
 #include <QString>
+#include "HeaderLayout.h"
 
 class QDataStream;
 
@@ -61,6 +62,8 @@ public:
     quint16 getMaxRecordSize() const;
 
 private:
+    static const HeaderField<PalmDOCHeader> FIELDS[7];
+
     //1 = no compression
     //2 = PalmDOC compression
     //17480 = HUFF/CDIC compression
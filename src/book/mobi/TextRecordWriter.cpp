@@ -0,0 +1,125 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "TextRecordWriter.h"
+#include "PalmDOCHeader.h"
+#include "MobiCodec.h"
+
+namespace {
+    //text is encoded in slices to keep pending bytes small
+    const int ENCODE_SLICE = 16 * 1024;
+    //UTF-8 character has at most three continuation bytes
+    const int MAX_OVERLAP = 3;
+
+    bool isContinuationByte(char byte)
+    {
+        return (static_cast<quint8>(byte) & 0xC0) == 0x80;
+    }
+}
+
+TextRecordWriter::TextRecordWriter(QTextCodec *codec, bool compress) :
+    m_codec(codec),
+    m_state(QTextCodec::IgnoreHeader),
+    //106 is MIB of UTF-8, other supported encodings use single bytes
+    m_multibyte(codec->mibEnum() == 106),
+    m_compress(compress),
+    m_textLength(0)
+{
+    Q_ASSERT(NULL != codec);
+}
+
+void TextRecordWriter::append(const QChar *text, int length)
+{
+    int start = 0;
+    for (int i = 0; i < length; ++i) {
+        if (text[i] == '\n' || i - start == ENCODE_SLICE) {
+            encode(text + start, i - start);
+            start = (text[i] == '\n') ? i + 1 : i;
+        }
+    }
+    encode(text + start, length - start);
+}
+
+void TextRecordWriter::finish()
+{
+    cutRecords(true);
+    if (!m_pending.isEmpty()) {
+        appendRecord(m_pending, QByteArray());
+        m_pending.clear();
+    }
+}
+
+const QList<QByteArray>& TextRecordWriter::records() const
+{
+    return m_records;
+}
+
+quint32 TextRecordWriter::textLength() const
+{
+    return m_textLength;
+}
+
+void TextRecordWriter::encode(const QChar *text, int length)
+{
+    if (length == 0) {
+        return;
+    }
+    const QByteArray encoded = m_codec->fromUnicode(text, length, &m_state);
+    m_textLength += encoded.size();
+    m_pending.append(encoded);
+    cutRecords(false);
+}
+
+void TextRecordWriter::cutRecords(bool final)
+{
+    const int recordSize = PalmDOCHeader::MAX_RECORD_SIZE;
+    //until the end of text, a character crossing the record end may be incomplete
+    const int required = final ? recordSize + 1 : recordSize + MAX_OVERLAP + 1;
+    int start = 0;
+    while (m_pending.size() - start >= required) {
+        int overlap = 0;
+        if (m_multibyte) {
+            while (overlap < MAX_OVERLAP && start + recordSize + overlap < m_pending.size() &&
+                   isContinuationByte(m_pending.at(start + recordSize + overlap)))
+            {
+                ++overlap;
+            }
+        }
+        appendRecord(m_pending.mid(start, recordSize), m_pending.mid(start + recordSize, overlap));
+        //next record starts with the repeated bytes
+        start += recordSize;
+    }
+    m_pending.remove(0, start);
+}
+
+void TextRecordWriter::appendRecord(const QByteArray &text, const QByteArray &overlap)
+{
+    QByteArray record;
+    if (m_compress) {
+        MobiCodec::EncodePalmDoc(text, record);
+    }
+    else {
+        record = text;
+    }
+    record.append(overlap);
+    record.append(static_cast<char>(overlap.size()));
+    m_records.append(record);
+}
@@ -0,0 +1,66 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_TEXT_RECORD_WRITER_H
+#define BLACK_MILORD_TEXT_RECORD_WRITER_H
+
+#include <QList>
+#include <QByteArray>
+#include <QTextCodec>
+
+class QChar;
+
+/**
+ * Encodes text straight into text records of PalmDOCHeader::MAX_RECORD_SIZE bytes.
+ * Line breaks are only added for editing by Formatting::formatHTMLContent,
+ * so they are skipped.
+ * Bytes of a character crossing the record end are repeated at the beginning
+ * of the next record and their count is written in the trailing multibyte entry.
+ * Text of every record is PalmDOC compressed when requested, the repeated bytes
+ * and the trailing entry are stored as they are.
+ */
+class TextRecordWriter
+{
+public:
+    TextRecordWriter(QTextCodec *codec, bool compress);
+
+    void append(const QChar *text, int length);
+    void finish();
+
+    const QList<QByteArray>& records() const;
+    //size of the encoded text without the repeated bytes and trailing entries
+    quint32 textLength() const;
+
+private:
+    void encode(const QChar *text, int length);
+    void cutRecords(bool final);
+    void appendRecord(const QByteArray &text, const QByteArray &overlap);
+
+    QTextCodec *m_codec;
+    QTextCodec::ConverterState m_state;
+    bool m_multibyte;
+    bool m_compress;
+    QByteArray m_pending;
+    QList<QByteArray> m_records;
+    quint32 m_textLength;
+};
+
+#endif /* BLACK_MILORD_TEXT_RECORD_WRITER_H */
@@ -0,0 +1,263 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "BatchProcessor.h"
+#include <QTextStream>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QVector>
+#include <QVariant>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+
+#include <AbstractBook.h>
+#include <Book.h>
+#include <MetadataScanner.h>
+#include <Spellcheck.h>
+#include <WordTokenizer.h>
+
+namespace {
+    struct ValidationResult
+    {
+        ValidationResult() :
+            ok(false),
+            characters(0),
+            words(0),
+            misspelled(0)
+        {
+        }
+
+        bool ok;
+        QString why;
+        int characters;
+        int words;
+        int misspelled;
+    };
+
+    class ValidateTask :
+        public QRunnable
+    {
+    public:
+        ValidateTask(const QString &fileName, bool spellcheck, ValidationResult &result) :
+            m_fileName(fileName),
+            m_spellcheck(spellcheck),
+            m_result(result)
+        {
+        }
+
+        void run()
+        {
+            QString text;
+            m_result.ok = AbstractBookFactory::getObject()->readText(m_fileName, text, m_result.why);
+            if (!m_result.ok) {
+                return;
+            }
+            m_result.characters = text.length();
+            WordTokenizer tokenizer(text);
+            tokenizer.setSkipUrls(true);
+            int start = 0;
+            int end = 0;
+            while (tokenizer.nextWord(start, end)) {
+                ++m_result.words;
+                if (m_spellcheck &&
+                    !Spellcheck::instance().checkWord(text.mid(start, end - start), tokenizer.language()))
+                {
+                    ++m_result.misspelled;
+                }
+            }
+        }
+
+    private:
+        const QString m_fileName;
+        const bool m_spellcheck;
+        ValidationResult &m_result;
+    };
+
+    QString jsonString(const QString &value)
+    {
+        QString result("\"");
+        for (int i = 0; i < value.length(); ++i) {
+            const ushort c = value[i].unicode();
+            if (c == '"' || c == '\\') {
+                result += '\\';
+                result += value[i];
+            }
+            else if (c < 0x20) {
+                result += QString("\\u%1").arg(c, 4, 16, QChar('0'));
+            }
+            else {
+                result += value[i];
+            }
+        }
+        result += '"';
+        return result;
+    }
+
+    //begins the report line of a file, command values are appended with member()
+    QString reportLine(const QString &fileName, bool ok, const QString &why)
+    {
+        return "{\"file\": " + jsonString(fileName) +
+               ", \"ok\": " + (ok ? "true" : "false") +
+               ", \"error\": " + jsonString(ok ? QString() : why);
+    }
+
+    QString member(const QString &name, const QString &value)
+    {
+        return ", " + jsonString(name) + ": " + jsonString(value);
+    }
+
+    QString member(const QString &name, qint64 value)
+    {
+        return ", " + jsonString(name) + ": " + QString::number(value);
+    }
+}
+
+BatchProcessor::BatchProcessor() :
+    m_threadCount(0),
+    m_spellcheck(false),
+    m_optimizePictures(false)
+{
+}
+
+void BatchProcessor::setThreadCount(int count)
+{
+    m_threadCount = count;
+}
+
+void BatchProcessor::setSpellcheck(bool enabled)
+{
+    m_spellcheck = enabled;
+}
+
+void BatchProcessor::setOptimizePictures(bool enabled)
+{
+    m_optimizePictures = enabled;
+}
+
+void BatchProcessor::setOutputDirectory(const QString &directory)
+{
+    m_outputDirectory = directory;
+}
+
+int BatchProcessor::run(Command command, const QStringList &fileNames, QTextStream &report)
+{
+    switch (command) {
+    case COMMAND_INFO:
+        return info(fileNames, report);
+    case COMMAND_VALIDATE:
+        return validate(fileNames, report);
+    case COMMAND_RESAVE:
+        return resave(fileNames, report);
+    }
+    Q_ASSERT(false);
+    return fileNames.size();
+}
+
+int BatchProcessor::info(const QStringList &fileNames, QTextStream &report)
+{
+    int failed = 0;
+    const QList<BookMetadata> results = MetadataScanner::scan(fileNames, m_threadCount);
+    for (int i = 0; i < results.size(); ++i) {
+        const BookMetadata &metadata = results[i];
+        QString line = reportLine(metadata.fileName, metadata.valid, metadata.why);
+        if (metadata.valid) {
+            line += member("subject", metadata.values.value(METADATA_SUBJECT).toString());
+            line += member("author", metadata.values.value(METADATA_AUTHOR).toString());
+            line += member("publisher", metadata.values.value(METADATA_PUBLISHER).toString());
+            line += member("language", metadata.values.value(METADATA_LANGUAGE).toString());
+            line += member("isbn", metadata.values.value(METADATA_ISBN).toString());
+            line += member("modified", metadata.values.value(METADATA_MODIFICATION_DATE).toDateTime().toString(Qt::ISODate));
+            line += member("coverBytes", metadata.cover.size());
+        }
+        else {
+            ++failed;
+        }
+        report << line << "}\n";
+    }
+    report.flush();
+    return failed;
+}
+
+int BatchProcessor::validate(const QStringList &fileNames, QTextStream &report)
+{
+    int failed = 0;
+    QVector<ValidationResult> results(fileNames.size());
+    QThreadPool pool;
+    if (m_threadCount > 0) {
+        pool.setMaxThreadCount(m_threadCount);
+    }
+    for (int i = 0; i < fileNames.size(); ++i) {
+        pool.start(new ValidateTask(fileNames[i], m_spellcheck, results[i]));
+    }
+    pool.waitForDone();
+    for (int i = 0; i < results.size(); ++i) {
+        const ValidationResult &result = results[i];
+        QString line = reportLine(fileNames[i], result.ok, result.why);
+        if (result.ok) {
+            line += member("characters", result.characters);
+            line += member("words", result.words);
+            if (m_spellcheck) {
+                line += member("misspelled", result.misspelled);
+            }
+        }
+        else {
+            ++failed;
+        }
+        report << line << "}\n";
+    }
+    report.flush();
+    return failed;
+}
+
+int BatchProcessor::resave(const QStringList &fileNames, QTextStream &report)
+{
+    //Book holds a single document, files are processed one by one
+    int failed = 0;
+    Book &book = Book::instance();
+    for (int i = 0; i < fileNames.size(); ++i) {
+        QString output = fileNames[i];
+        if (!m_outputDirectory.isEmpty()) {
+            output = QDir(m_outputDirectory).absoluteFilePath(QFileInfo(fileNames[i]).fileName());
+        }
+        qint64 savedBytes = 0;
+        bool ok = book.openFile(fileNames[i]);
+        if (ok) {
+            if (m_optimizePictures) {
+                savedBytes = book.optimizePictures();
+            }
+            book.setFileName(output);
+            ok = book.saveFile();
+        }
+        QString line = reportLine(fileNames[i], ok, book.getWhy());
+        if (ok) {
+            line += member("output", output);
+            line += member("savedPictureBytes", savedBytes);
+        }
+        else {
+            ++failed;
+        }
+        book.closeFile();
+        report << line << "}\n";
+        report.flush();
+    }
+    return failed;
+}
@@ -0,0 +1,74 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_BATCH_PROCESSOR_H
+#define BLACK_MILORD_BATCH_PROCESSOR_H
+
+#include <QString>
+#include <QStringList>
+
+class QTextStream;
+
+/**
+ * Runs a command over many books without the editor window.
+ * Every file produces one line of the report, a JSON object with "file", "ok"
+ * and "error" members followed by values specific to the command.
+ * Reading commands run in a pool of worker threads, re-saving goes through Book
+ * and processes files one after another.
+ */
+class BatchProcessor
+{
+public:
+    enum Command {
+        //metadata and cover size, only headers are read
+        COMMAND_INFO,
+        //decodes the text, optionally counts misspelled words
+        COMMAND_VALIDATE,
+        //opens, normalizes and saves the book with recompressed text
+        COMMAND_RESAVE
+    };
+
+    BatchProcessor();
+
+    //number of worker threads, ideal thread count is used when it is not positive
+    void setThreadCount(int count);
+    void setSpellcheck(bool enabled);
+    void setOptimizePictures(bool enabled);
+    //re-saved books are written there, when empty they replace the original files
+    void setOutputDirectory(const QString &directory);
+
+    /**
+     * @return number of files which failed.
+     */
+    int run(Command command, const QStringList &fileNames, QTextStream &report);
+
+private:
+    int info(const QStringList &fileNames, QTextStream &report);
+    int validate(const QStringList &fileNames, QTextStream &report);
+    int resave(const QStringList &fileNames, QTextStream &report);
+
+    int m_threadCount;
+    bool m_spellcheck;
+    bool m_optimizePictures;
+    QString m_outputDirectory;
+};
+
+#endif /* BLACK_MILORD_BATCH_PROCESSOR_H */
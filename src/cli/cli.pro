@@ -0,0 +1,20 @@
+TEMPLATE = app
+CONFIG += qt console
+CONFIG -= app_bundle
+QT = core gui
+TARGET = blackmilord-cli
+
+LIBS += -lblackmilord
+
+include(../../project.pri)
+
+#objects of shared sources must not mix with the editor's main.cpp
+OBJECTS_DIR = $$BLACK_MILORD_BUILD_ROOT/build/$$DESTPREFIX/cli
+MOC_DIR = $$BLACK_MILORD_BUILD_ROOT/build/$$DESTPREFIX/cli
+
+include(../src.pri)
+
+SOURCES += main.cpp
+SOURCES += BatchProcessor.cpp
+
+HEADERS += BatchProcessor.h
@@ -0,0 +1,137 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include <QApplication>
+#include <QTextStream>
+#include <QStringList>
+#include <QFileInfo>
+#include <QDir>
+#include <MetadataScanner.h>
+#include <Spellcheck.h>
+#include "BatchProcessor.h"
+
+namespace {
+    const int EXIT_FILES_FAILED = 1;
+    const int EXIT_USAGE = 2;
+
+    int usage(QTextStream &err)
+    {
+        err << "Usage: blackmilord-cli COMMAND [OPTIONS] FILE|DIRECTORY...\n"
+            << "\n"
+            << "Commands:\n"
+            << "  info                  metadata of the books, only headers are read\n"
+            << "  validate              decode the text of the books\n"
+            << "  resave                normalize, recompress and save the books\n"
+            << "\n"
+            << "Options:\n"
+            << "  -j N                  number of worker threads\n"
+            << "  -o DIRECTORY          write re-saved books there instead of replacing them\n"
+            << "  --spellcheck          count misspelled words when validating\n"
+            << "  --optimize-pictures   fit pictures to the device when re-saving\n"
+            << "\n"
+            << "One JSON object per file is printed to the standard output.\n";
+        err.flush();
+        return EXIT_USAGE;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    //no window is shown, the tool runs without a display
+    QApplication app(argc, argv, false);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    out.setCodec("UTF-8");
+
+    QStringList arguments = app.arguments();
+    arguments.removeFirst();
+    if (arguments.isEmpty()) {
+        return usage(err);
+    }
+
+    BatchProcessor processor;
+    BatchProcessor::Command command = BatchProcessor::COMMAND_INFO;
+    const QString commandName = arguments.takeFirst();
+    if (commandName == "info") {
+        command = BatchProcessor::COMMAND_INFO;
+    }
+    else if (commandName == "validate") {
+        command = BatchProcessor::COMMAND_VALIDATE;
+    }
+    else if (commandName == "resave") {
+        command = BatchProcessor::COMMAND_RESAVE;
+    }
+    else {
+        return usage(err);
+    }
+
+    QStringList fileNames;
+    bool spellcheck = false;
+    while (!arguments.isEmpty()) {
+        const QString argument = arguments.takeFirst();
+        if (argument == "-j" && !arguments.isEmpty()) {
+            bool ok = false;
+            processor.setThreadCount(arguments.takeFirst().toInt(&ok));
+            if (!ok) {
+                return usage(err);
+            }
+        }
+        else if (argument == "-o" && !arguments.isEmpty()) {
+            const QString directory = arguments.takeFirst();
+            if (!QFileInfo(directory).isDir()) {
+                err << "Output directory does not exist: " << directory << "\n";
+                return EXIT_USAGE;
+            }
+            processor.setOutputDirectory(directory);
+        }
+        else if (argument == "--spellcheck") {
+            spellcheck = true;
+        }
+        else if (argument == "--optimize-pictures") {
+            processor.setOptimizePictures(true);
+        }
+        else if (argument.startsWith("-")) {
+            return usage(err);
+        }
+        else if (QFileInfo(argument).isDir()) {
+            fileNames << MetadataScanner::bookFiles(argument);
+        }
+        else {
+            fileNames << argument;
+        }
+    }
+    if (fileNames.isEmpty()) {
+        return usage(err);
+    }
+    //dictionary is loaded here, before worker threads use it
+    if (spellcheck && !Spellcheck::instance().isLoaded()) {
+        err << "Spellcheck dictionary is not available\n";
+        return EXIT_USAGE;
+    }
+    processor.setSpellcheck(spellcheck);
+
+    const int failed = processor.run(command, fileNames, out);
+    if (failed > 0) {
+        err << failed << " of " << fileNames.size() << " files failed\n";
+        return EXIT_FILES_FAILED;
+    }
+    return 0;
+}
@@ -28,9 +28,10 @@
 #include <QHBoxLayout>
 #include <QPushButton>
 #include <QLineEdit>
-#include <QRegExp>
 #include <QTextCursor>
 #include <QShowEvent>
+#include <QHideEvent>
+#include <QListWidget>
 #include <QCompleter>
 #include <QMessageBox>
 #include <QDateTime>
@@ -38,9 +39,12 @@
 #include <Gui.h>
 #include <PlainTextEditor.h>
 #include <StatusBar.h>
+#include <Book.h>
 
 FindReplaceWindow::FindReplaceWindow(QWidget *parent) :
     QDialog(parent),
+    m_findAllActive(false),
+    m_findAllGeneration(0),
     m_notFoundLastTime(false)
 {
     QHBoxLayout *layout = new QHBoxLayout();
@@ -85,10 +89,12 @@ FindReplaceWindow::FindReplaceWindow(QWidget *parent) :
     m_findNextButton = new QPushButton(tr("Fin&d next"));
     m_replaceButton = new QPushButton(tr("&Replace"));
     m_replaceAllButton = new QPushButton(tr("Repl&ace All"));
+    m_findAllButton = new QPushButton(tr("Find a&ll"));
     QPushButton *closeButton = new QPushButton(tr("Close"));
     buttonsLayout->addWidget(m_findNextButton);
     buttonsLayout->addWidget(m_replaceButton);
     buttonsLayout->addWidget(m_replaceAllButton);
+    buttonsLayout->addWidget(m_findAllButton);
     buttonsLayout->addStretch(1);
     buttonsLayout->addWidget(closeButton);
 
@@ -96,9 +102,29 @@ FindReplaceWindow::FindReplaceWindow(QWidget *parent) :
     layout->addLayout(controlsLayout, 1);
     layout->addLayout(buttonsLayout, 0);
 
+    //results of find all, shown once it is used
+    m_resultsInfo = new QLabel();
+    m_results = new QListWidget();
+    m_results->setUniformItemSizes(true);
+    m_results->setMinimumHeight(150);
+    m_resultsInfo->hide();
+    m_results->hide();
+
+    QVBoxLayout *mainLayout = new QVBoxLayout();
+    mainLayout->addLayout(layout, 0);
+    mainLayout->addWidget(m_resultsInfo, 0);
+    mainLayout->addWidget(m_results, 1);
+
+    m_findAllTimer.setSingleShot(true);
+    m_findAllTimer.setInterval(200);
+    connect(&m_findAllTimer, SIGNAL(timeout()), this, SLOT(startFindAll()));
+
     connect(m_findNextButton, SIGNAL(released()), this, SLOT(find()));
     connect(m_replaceButton, SIGNAL(released()), this, SLOT(replace()));
     connect(m_replaceAllButton, SIGNAL(released()), this, SLOT(replaceAll()));
+    connect(m_findAllButton, SIGNAL(released()), this, SLOT(findAll()));
+    connect(m_results, SIGNAL(itemClicked(QListWidgetItem *)), this, SLOT(resultActivated(QListWidgetItem *)));
+    connect(m_results, SIGNAL(itemActivated(QListWidgetItem *)), this, SLOT(resultActivated(QListWidgetItem *)));
     connect(closeButton, SIGNAL(released()), this, SLOT(close()));
 
     connect(m_findWhat, SIGNAL(editTextChanged(const QString &)), this, SLOT(updateButtons()));
@@ -109,13 +135,23 @@ FindReplaceWindow::FindReplaceWindow(QWidget *parent) :
     connect(m_wordsOnly, SIGNAL(toggled(bool)), this, SLOT(checkboxChanged()));
     connect(m_caseSensitive, SIGNAL(toggled(bool)), this, SLOT(checkboxChanged()));
 
-    setLayout(layout);
+    connect(m_findWhat, SIGNAL(editTextChanged(const QString &)), this, SLOT(scheduleFindAll()));
+    connect(m_regExp, SIGNAL(toggled(bool)), this, SLOT(scheduleFindAll()));
+    connect(m_wordsOnly, SIGNAL(toggled(bool)), this, SLOT(scheduleFindAll()));
+    connect(m_caseSensitive, SIGNAL(toggled(bool)), this, SLOT(scheduleFindAll()));
+    connect(&Book::instance(), SIGNAL(textChanged()), this, SLOT(scheduleFindAll()));
+
+    setLayout(mainLayout);
     setWindowTitle(tr("Find and Replace"));
     setWindowIcon(QIcon(":/resource/icon/menu_find_and_replace.png"));
 }
 
 FindReplaceWindow::~FindReplaceWindow()
 {
+    //canceled thread posts no more events, no need to wait for it
+    if (m_findAllThread) {
+        m_findAllThread->cancel();
+    }
 }
 
 void FindReplaceWindow::showEvent(QShowEvent *event)
@@ -128,19 +164,28 @@ void FindReplaceWindow::showEvent(QShowEvent *event)
     m_findWhat->setFocus();
 }
 
-QRegExp FindReplaceWindow::prepareQuery() const
+void FindReplaceWindow::hideEvent(QHideEvent *event)
 {
-    QString pattern = m_findWhat->currentText();
-    if (!m_regExp->isChecked()) {
-        pattern = QRegExp::escape(pattern);
+    stopFindAll();
+    m_findAllActive = false;
+    m_resultsInfo->hide();
+    m_results->hide();
+    QDialog::hideEvent(event);
+}
+
+void FindReplaceWindow::prepareSearch()
+{
+    int options = TextSearch::OPTION_NONE;
+    if (m_regExp->isChecked()) {
+        options |= TextSearch::OPTION_REGEXP;
     }
     if (m_wordsOnly->isChecked()) {
-        pattern = "\\b" + pattern + "\\b";
+        options |= TextSearch::OPTION_WORDS_ONLY;
     }
-    QRegExp rx(pattern);
-    rx.setMinimal(true);
-    rx.setCaseSensitivity(m_caseSensitive->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive);
-    return rx;
+    if (m_caseSensitive->isChecked()) {
+        options |= TextSearch::OPTION_CASE_SENSITIVE;
+    }
+    m_search.setPattern(m_findWhat->currentText(), options);
 }
 
 void FindReplaceWindow::find(bool showDialogs)
@@ -150,9 +195,9 @@ void FindReplaceWindow::find(bool showDialogs)
         saveValues();
     }
 
-    const QString &text = Gui::plainTextEditor()->toPlainText();
+    const PieceTable text = Book::instance().getTextSnapshot();
 
-    QRegExp rx = prepareQuery();
+    prepareSearch();
 
     //find text
     int from = Gui::plainTextEditor()->getCursorPosition();
@@ -162,15 +207,14 @@ void FindReplaceWindow::find(bool showDialogs)
         if (Gui::plainTextEditor()->hasSelection()) {
             from = Gui::plainTextEditor()->getSelectionStart();
         }
-        position = text.lastIndexOf(rx, from - 1);
+        position = m_search.lastIndexIn(text, from - 1, length);
     }
     else {
         if (Gui::plainTextEditor()->hasSelection()) {
             from = Gui::plainTextEditor()->getSelectionEnd();
         }
-        position = text.indexOf(rx, from);
+        position = m_search.indexIn(text, from, length);
     }
-    length = rx.matchedLength();
 
     //handle result
     if (position != -1) {
@@ -255,28 +299,124 @@ void FindReplaceWindow::replace()
 void FindReplaceWindow::replaceAll()
 {
     saveValues();
-    unsigned count = 0;
-    PlainTextEditor *editor = Gui::plainTextEditor();
-    const QString &replaceWith = m_replaceWith->currentText();
-    QRegExp rx = prepareQuery();
-    QString text = editor->toPlainText();
-
-    int offset = rx.indexIn(text);
-    while (-1 != offset) {
-        ++count;
-        offset += rx.matchedLength();
-        offset = rx.indexIn(text, offset);
+    prepareSearch();
+    const PieceTable text = Book::instance().getTextSnapshot();
+    const QVector<TextReplacement> matches = m_search.replacements(text, m_replaceWith->currentText());
+
+    //occurrences which would not change are left untouched
+    QVector<TextReplacement> replacements;
+    int shift = 0;
+    int cursorPosition = -1;
+    foreach (const TextReplacement &match, matches) {
+        if (match.after.length() == match.length && text.mid(match.position, match.length) == match.after) {
+            continue;
+        }
+        replacements.append(match);
+        shift += match.after.length() - match.length;
+        cursorPosition = match.position + match.length + shift;
+    }
+    Book::instance().replaceText(replacements);
+    if (cursorPosition != -1) {
+        Gui::plainTextEditor()->setCursorPosition(cursorPosition);
     }
 
-    text.replace(rx, replaceWith);
-    Gui::plainTextEditor()->setPlainText(text);
-    //TODO: set cursor to last replaced occurrence
-    Gui::plainTextEditor()->setCursorPositionToEnd();
-
-    QString message = tr("Repleced") + " " + QString::number(count) + " " + tr("occurrences");
+    QString message = tr("Repleced") + " " + QString::number(replacements.size()) + " " + tr("occurrences");
     Gui::statusBar()->showMessage(message, 3000);
 }
 
+void FindReplaceWindow::findAll()
+{
+    saveValues();
+    m_findAllActive = true;
+    m_resultsInfo->show();
+    m_results->show();
+    m_findAllTimer.stop();
+    startFindAll();
+}
+
+void FindReplaceWindow::scheduleFindAll()
+{
+    //wait until typing stops, previous results are dropped when the search restarts
+    if (m_findAllActive) {
+        m_findAllTimer.start();
+    }
+}
+
+void FindReplaceWindow::stopFindAll()
+{
+    m_findAllTimer.stop();
+    if (m_findAllThread) {
+        m_findAllThread->cancel();
+        m_findAllThread = NULL;
+    }
+    //results of the canceled search are ignored
+    ++m_findAllGeneration;
+    m_results->clear();
+    m_highlights.clear();
+    if (Gui::hasPlainTextEditor()) {
+        Gui::plainTextEditor()->clearSearchHighlights();
+    }
+}
+
+void FindReplaceWindow::startFindAll()
+{
+    stopFindAll();
+    if (m_findWhat->currentText().isEmpty()) {
+        m_resultsInfo->clear();
+        return;
+    }
+    prepareSearch();
+    if (!m_search.isValid()) {
+        m_resultsInfo->setText(tr("Invalid search pattern"));
+        return;
+    }
+    m_resultsInfo->setText(tr("Searching..."));
+    m_findAllThread = new FindAllThread(this, m_findAllGeneration, Book::instance().getTextSnapshot(),
+        m_search.pattern(), m_search.options());
+    m_findAllThread->start(QThread::LowPriority);
+}
+
+void FindReplaceWindow::customEvent(QEvent *event)
+{
+    if (event->type() != FindAllResultEvent::getType()) {
+        QDialog::customEvent(event);
+        return;
+    }
+    event->accept();
+    FindAllResultEvent *resultEvent = dynamic_cast<FindAllResultEvent*>(event);
+    if (resultEvent->getGeneration() != m_findAllGeneration) {
+        return;
+    }
+    foreach (const FindAllMatch &match, resultEvent->getMatches()) {
+        QListWidgetItem *item = new QListWidgetItem(
+            QString::number(match.line + 1) + ": " + match.snippet, m_results);
+        item->setData(Qt::UserRole, match.position);
+        item->setData(Qt::UserRole + 1, match.length);
+        m_highlights.append(qMakePair(match.position, match.length));
+    }
+    if (resultEvent->isFinished()) {
+        m_findAllThread = NULL;
+        //highlights are rebuilt as a whole, so they are set only once
+        Gui::plainTextEditor()->setSearchHighlights(m_highlights);
+        QString message = tr("Found") + " " + QString::number(m_results->count()) + " " + tr("occurrences");
+        if (m_results->count() >= FindAllThread::MAX_MATCHES) {
+            message = tr("Showing the first") + " " + QString::number(m_results->count()) + " " + tr("occurrences");
+        }
+        m_resultsInfo->setText(message);
+    }
+}
+
+void FindReplaceWindow::resultActivated(QListWidgetItem *item)
+{
+    const int position = item->data(Qt::UserRole).toInt();
+    const int length = item->data(Qt::UserRole + 1).toInt();
+    //text could have been changed since the search
+    if (position + length <= Book::instance().getTextLength()) {
+        Gui::plainTextEditor()->setSelection(position, position + length);
+        Gui::plainTextEditor()->setFocus();
+    }
+}
+
 void FindReplaceWindow::checkboxChanged()
 {
     if (m_regExp->isChecked()) {
@@ -291,6 +431,7 @@ void FindReplaceWindow::updateButtons()
     m_replaceButton->setEnabled(!m_findWhat->currentText().isEmpty());
     m_replaceAllButton->setEnabled(!m_findWhat->currentText().isEmpty() &&
         m_findWhat->currentText() != m_replaceWith->currentText());
+    m_findAllButton->setEnabled(!m_findWhat->currentText().isEmpty());
 }
 
 void FindReplaceWindow::saveValues()
@@ -23,14 +23,23 @@
 #define BLACK_MILORD_FIND_REPLACE_WINDOW_H
 
 #include <QDialog>
+#include <QTimer>
+#include <QPointer>
+#include <QVector>
+#include <QPair>
 
 #include "SpellCheckingWindow.h"
+#include <TextSearch.h>
+#include <FindAllThread.h>
 
-class QRegExp;
 class QComboBox;
 class QCheckBox;
 class QPushButton;
 class QShowEvent;
+class QHideEvent;
+class QLabel;
+class QListWidget;
+class QListWidgetItem;
 
 class FindReplaceWindow : public QDialog
 {
@@ -41,7 +50,16 @@ public:
 
 private:
     void saveValues();
-    QRegExp prepareQuery() const;
+    void prepareSearch();
+    void stopFindAll();
+
+    TextSearch m_search;
+    //find all runs again when the pattern, options or text change
+    bool m_findAllActive;
+    int m_findAllGeneration;
+    QPointer<FindAllThread> m_findAllThread;
+    QTimer m_findAllTimer;
+    QVector<QPair<int, int> > m_highlights;
 
     bool m_notFoundLastTime;
     QComboBox *m_findWhat;
@@ -53,15 +71,24 @@ private:
     QPushButton *m_findNextButton;
     QPushButton *m_replaceButton;
     QPushButton *m_replaceAllButton;
+    QPushButton *m_findAllButton;
+    QLabel *m_resultsInfo;
+    QListWidget *m_results;
 private slots:
     void find(bool showDialogs = true);
     void replace();
     void replaceAll();
+    void findAll();
+    void scheduleFindAll();
+    void startFindAll();
+    void resultActivated(QListWidgetItem *item);
     void checkboxChanged();
     void updateButtons();
 
 protected:
     void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+    void customEvent(QEvent *event);
 };
 
 #endif /* BLACK_MILORD_FIND_REPLACE_WINDOW_H */
@@ -31,6 +31,7 @@
 #include <Dictionary.h>
 #include <MetadataEnum.h>
 #include <Book.h>
+#include <HighlighterManager.h>
 
 MetaDataWindow::MetaDataWindow(QWidget *parent) :
     QDialog(parent)
@@ -67,6 +68,9 @@ MetaDataWindow::MetaDataWindow(QWidget *parent) :
     dataLayout->addWidget(new QLabel(Dictionary::bookMetaDataLabel(METADATA_SUBJECT)), 4, 0);
     dataLayout->addWidget(m_subject = new QLineEdit(), 4 , 1);
 
+    dataLayout->addWidget(new QLabel(Dictionary::bookMetaDataLabel(METADATA_LANGUAGE)), 5, 0);
+    dataLayout->addWidget(m_language = new QLineEdit(), 5 , 1);
+
     /*
     METADATA_VERSION,
     METADATA_CREATION_DATE,
@@ -101,6 +105,11 @@ void MetaDataWindow::apply()
     Book::instance().setMetadata(METADATA_DESCRIPTION, m_description->text());
     Book::instance().setMetadata(METADATA_ISBN, m_isbn->text());
     Book::instance().setMetadata(METADATA_SUBJECT, m_subject->text());
+    if (m_language->text() != Book::instance().getMetadata(METADATA_LANGUAGE).toString()) {
+        Book::instance().setMetadata(METADATA_LANGUAGE, m_language->text());
+        //words are checked against another dictionary now
+        HighlighterManager::instance().rehighlight();
+    }
 }
 
 void MetaDataWindow::ok()
@@ -123,4 +132,5 @@ void MetaDataWindow::metadataChanged()
     m_description->setText(Book::instance().getMetadata(METADATA_DESCRIPTION).toString());
     m_isbn->setText(Book::instance().getMetadata(METADATA_ISBN).toString());
     m_subject->setText(Book::instance().getMetadata(METADATA_SUBJECT).toString());
+    m_language->setText(Book::instance().getMetadata(METADATA_LANGUAGE).toString());
 }
@@ -48,6 +48,7 @@ private:
     QLineEdit *m_description;
     QLineEdit *m_isbn;
     QLineEdit *m_subject;
+    QLineEdit *m_language;
 };
 
 #endif /* BLACK_MILORD_METADATA_WINDOW_H */
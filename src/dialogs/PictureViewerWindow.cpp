@@ -30,29 +30,54 @@
 #include <QString>
 #include <QMenu>
 #include <QMessageBox>
+#include <QIcon>
+#include <QApplication>
+#include <QFileDialog>
+#include <QDir>
+#include <QFileInfo>
 
 #include <Book.h>
 #include <XMLElement.h>
 #include <PlainTextEditor.h>
 #include <Gui.h>
 
+namespace {
+    const int THUMBNAIL_SIZE = 64;
+    //limit of memory used by decoded pictures, in kilobytes
+    const int PICTURE_CACHE_SIZE = 64 * 1024;
+}
+
 PictureViewerWindow::PictureViewerWindow(QWidget *parent) :
     QDialog(parent, Qt::Window),
     m_graphicsScene(new QGraphicsScene()),
     m_graphicsView(new QGraphicsView(m_graphicsScene)),
-    m_contentsWidget(new QListWidget())
+    m_contentsWidget(new QListWidget()),
+    m_pictureCache(PICTURE_CACHE_SIZE),
+    m_thumbnailGeneration(0)
 {
-    m_contentsWidget->setFixedWidth(100);
+    m_contentsWidget->setFixedWidth(THUMBNAIL_SIZE + 50);
+    m_contentsWidget->setViewMode(QListView::IconMode);
+    m_contentsWidget->setFlow(QListView::TopToBottom);
+    m_contentsWidget->setWrapping(false);
+    m_contentsWidget->setMovement(QListView::Static);
+    m_contentsWidget->setUniformItemSizes(true);
+    m_contentsWidget->setIconSize(QSize(THUMBNAIL_SIZE, THUMBNAIL_SIZE));
     m_contentsWidget->setContextMenuPolicy(Qt::CustomContextMenu);
 
     QVBoxLayout *mainLayout = new QVBoxLayout();
     QHBoxLayout *buttonLayout = new QHBoxLayout();
     QHBoxLayout *imageLayout = new QHBoxLayout();
 
+    QPushButton *importButton = new QPushButton(tr("&Import directory..."));
+    QPushButton *optimizeButton = new QPushButton(tr("&Optimize for device"));
     QPushButton *closeButton = new QPushButton(tr("Close"));
 
+    buttonLayout->addWidget(importButton);
+    buttonLayout->addWidget(optimizeButton);
     buttonLayout->addStretch(1);
     buttonLayout->addWidget(closeButton);
+    connect(importButton, SIGNAL(released()), this, SLOT(importImages()));
+    connect(optimizeButton, SIGNAL(released()), this, SLOT(optimizeImages()));
     connect(closeButton, SIGNAL(released()), this, SLOT(close()));
 
     imageLayout->addWidget(m_contentsWidget, 0);
@@ -73,6 +98,10 @@ PictureViewerWindow::PictureViewerWindow(QWidget *parent) :
 
 PictureViewerWindow::~PictureViewerWindow()
 {
+    //canceled thread posts no more events, no need to wait for it
+    if (m_thumbnailThread) {
+        m_thumbnailThread->cancel();
+    }
 }
 
 void PictureViewerWindow::clearView()
@@ -107,17 +136,70 @@ void PictureViewerWindow::showEvent(QShowEvent *event)
 
 void PictureViewerWindow::reloadImageList()
 {
+    //indexes of pictures may have changed
+    m_pictureCache.clear();
     m_contentsWidget->clear();
     for (int i = 0; i < Book::instance().getPicturesCount(); ++i) {
         m_contentsWidget->addItem(tr("Image") + " " + QString::number(i));
     }
+    loadThumbnails();
+}
+
+void PictureViewerWindow::loadThumbnails()
+{
+    stopThumbnails();
+    QList<QByteArray> pictures;
+    for (int i = 0; i < Book::instance().getPicturesCount(); ++i) {
+        pictures.append(Book::instance().getPicture(i).getCurrentPictureData());
+    }
+    if (!pictures.isEmpty()) {
+        m_thumbnailThread = new ThumbnailThread(this, m_thumbnailGeneration, pictures,
+            QSize(THUMBNAIL_SIZE, THUMBNAIL_SIZE));
+        m_thumbnailThread->start(QThread::LowPriority);
+    }
+}
+
+void PictureViewerWindow::stopThumbnails()
+{
+    if (m_thumbnailThread) {
+        m_thumbnailThread->cancel();
+        m_thumbnailThread = NULL;
+    }
+    //thumbnails of the canceled run are ignored
+    ++m_thumbnailGeneration;
+}
+
+void PictureViewerWindow::customEvent(QEvent *event)
+{
+    if (event->type() != ThumbnailEvent::getType()) {
+        QDialog::customEvent(event);
+        return;
+    }
+    event->accept();
+    ThumbnailEvent *thumbnailEvent = dynamic_cast<ThumbnailEvent*>(event);
+    if (thumbnailEvent->getGeneration() != m_thumbnailGeneration) {
+        return;
+    }
+    QListWidgetItem *item = m_contentsWidget->item(thumbnailEvent->getIndex());
+    if (item && !thumbnailEvent->getThumbnail().isNull()) {
+        item->setIcon(QIcon(QPixmap::fromImage(thumbnailEvent->getThumbnail())));
+    }
 }
 
 void PictureViewerWindow::currentRowChanged(int currentRow)
 {
-    if (currentRow >= 0) {
-        showImage(Book::instance().getPicture(currentRow).getCurrentPicture());
+    if (currentRow < 0) {
+        return;
     }
+    QPixmap *cached = m_pictureCache.object(currentRow);
+    if (cached) {
+        showImage(*cached);
+        return;
+    }
+    const QPixmap picture = Book::instance().getPicture(currentRow).getCurrentPicture();
+    const qint64 cost = static_cast<qint64>(picture.width()) * picture.height() * picture.depth() / 8 / 1024;
+    m_pictureCache.insert(currentRow, new QPixmap(picture), static_cast<int>(qBound<qint64>(1, cost, PICTURE_CACHE_SIZE)));
+    showImage(picture);
 }
 
 void PictureViewerWindow::showContextMenuForWidget(const QPoint &pos)
@@ -142,27 +224,13 @@ void PictureViewerWindow::removeImage()
 void PictureViewerWindow::findInDocument()
 {
     int currentRow = m_contentsWidget->currentRow();
-    int from = 0;
     XMLElement element;
-    do
-    {
-        element = Gui::plainTextEditor()->findXMLElement("img", from);
-        if (element.startPos() == -1 || element.endPos() == -1) {
-            break;
-        }
-
-        from = element.endPos() + 1;
-
-        if (!element.hasAttribute(XMLElement::BOOK_INDEX_ATTRIBUTE)) {
-            continue;
-        }
-
-        bool ok = false;
-        int index = element.attribute(XMLElement::BOOK_INDEX_ATTRIBUTE).toInt(&ok);
-        if (ok && (index == currentRow)) {
+    foreach (const XMLElement &image, Book::instance().findXMLElements("img")) {
+        if (Book::pictureIndex(image.attribute(XMLElement::BOOK_INDEX_ATTRIBUTE)) == currentRow) {
+            element = image;
             break;
         }
-    } while (true);
+    }
 
     if (element.startPos() != -1 && element.endPos() != -1) {
         Gui::plainTextEditor()->setSelection(element.startPos(), element.endPos());
@@ -172,4 +240,64 @@ void PictureViewerWindow::findInDocument()
                 tr("Not found"),
                 tr("Image has beem not found in document."));
     }
-}
\ No newline at end of file
+}
+
+void PictureViewerWindow::optimizeImages()
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const qint64 saved = Book::instance().optimizePictures();
+    QApplication::restoreOverrideCursor();
+
+    const int currentRow = m_contentsWidget->currentRow();
+    reloadImageList();
+    m_contentsWidget->setCurrentRow(currentRow);
+    QMessageBox::information(this, tr("Images optimized"),
+        tr("Images were fitted to the device.") + "\n" +
+        tr("Saved") + " " + QString::number(saved / 1024) + " KB");
+}
+
+void PictureViewerWindow::importImages()
+{
+    const QString directory = QFileDialog::getExistingDirectory(this, tr("Import images"));
+    if (directory.isEmpty()) {
+        return;
+    }
+    QStringList filters;
+    filters << "*.jpg" << "*.jpeg" << "*.gif" << "*.png" << "*.bmp";
+    QStringList fileNames;
+    QDir dir(directory);
+    foreach (const QString &fileName, dir.entryList(filters, QDir::Files | QDir::Readable, QDir::Name | QDir::IgnoreCase)) {
+        fileNames.append(dir.absoluteFilePath(fileName));
+    }
+    if (fileNames.isEmpty()) {
+        QMessageBox::information(this, tr("Import images"), tr("There are no images in the directory."));
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const QList<int> indexes = Book::instance().importPictures(fileNames);
+    QApplication::restoreOverrideCursor();
+    reloadImageList();
+
+    QStringList tags;
+    QStringList failed;
+    for (int i = 0; i < indexes.size(); ++i) {
+        if (indexes[i] == -1) {
+            failed.append(QFileInfo(fileNames[i]).fileName());
+            continue;
+        }
+        XMLElement image("img");
+        image.setAttribute(XMLElement::BOOK_INDEX_ATTRIBUTE, Book::pictureReference(indexes[i]));
+        tags.append(image.formatElement());
+    }
+    if (!failed.isEmpty()) {
+        QMessageBox::warning(this, tr("Import images"),
+            tr("These files could not be imported:") + "\n" + failed.join("\n"));
+    }
+    if (!tags.isEmpty() && QMessageBox::Yes == QMessageBox::question(this, tr("Import images"),
+        tr("Insert imported images at the cursor position?"), QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes))
+    {
+        const int position = Gui::plainTextEditor()->getCursorPosition();
+        Gui::plainTextEditor()->replace(position, 0, tags.join("\n") + "\n");
+    }
+}
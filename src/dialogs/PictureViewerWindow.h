@@ -23,10 +23,14 @@
 #define BLACK_MILORD_PICTURE_VIEWER_WINDOW_H
 
 #include <QDialog>
+#include <QCache>
+#include <QPixmap>
+#include <QPointer>
+
+#include <ThumbnailThread.h>
 
 class QGraphicsScene;
 class QGraphicsView;
-class QPixmap;
 class QListWidget;
 class QString;
 
@@ -39,11 +43,19 @@ public:
 
 protected:
     void showEvent(QShowEvent *event);
+    void customEvent(QEvent *event);
 
 private:
     QGraphicsScene *m_graphicsScene;
     QGraphicsView *m_graphicsView;
     QListWidget *m_contentsWidget;
+    //recently shown pictures, cost in kilobytes
+    QCache<int, QPixmap> m_pictureCache;
+    QPointer<ThumbnailThread> m_thumbnailThread;
+    int m_thumbnailGeneration;
+
+    void loadThumbnails();
+    void stopThumbnails();
 
     void showImage(const QPixmap &image);
     void showText(const QString &text);
@@ -55,6 +67,8 @@ private slots:
     void showContextMenuForWidget(const QPoint &);
     void removeImage();
     void findInDocument();
+    void optimizeImages();
+    void importImages();
 };
 
 #endif /* BLACK_MILORD_PICTURE_VIEWER_WINDOW_H */
\ No newline at end of file
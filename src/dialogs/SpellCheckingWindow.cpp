@@ -28,26 +28,44 @@
 #include <QStringListModel>
 #include <QListView>
 #include <QComboBox>
-#include <QRegExp>
+#include <QVector>
 #include <QShowEvent>
 #include <QDebug>
 #include <QMessageBox>
 #include <QCoreApplication>
+#include <QTextBoundaryFinder>
 
 #include <Gui.h>
 #include <PlainTextEditor.h>
 #include <Dictionary.h>
 #include <Spellcheck.h>
+#include <WordTokenizer.h>
 #include <Preferences.h>
+#include <Book.h>
 
 namespace {
     const QString BUTTON_LABEL_IGNORE_ONCE(QObject::tr("Ignore Once"));
     const QString BUTTON_LABEL_UNDO_EDIT(QObject::tr("Undo Edit"));
+    const int SENTENCE_SEARCH_RANGE = 1024;
+
+    inline bool isWordCharacter(const QChar &c)
+    {
+        return c.isLetterOrNumber() || c == '_';
+    }
+
+    //Same semantics as \b in regular expression.
+    bool isWordBoundary(const QString &text, int position)
+    {
+        bool before = position > 0 && isWordCharacter(text.at(position - 1));
+        bool after = position < text.length() && isWordCharacter(text.at(position));
+        return before != after;
+    }
 }
 
 SpellCheckingWindow::SpellCheckingWindow(QWidget *parent) :
     QDialog(parent),
-    m_finder(NULL)
+    m_tokenizer(NULL),
+    m_textDirty(true)
 {
     m_findNextEventType = QEvent::registerEventType();
 
@@ -119,62 +137,50 @@ SpellCheckingWindow::SpellCheckingWindow(QWidget *parent) :
 
 SpellCheckingWindow::~SpellCheckingWindow()
 {
+    delete m_tokenizer;
 }
 
 void SpellCheckingWindow::findNextWord()
 {
-    int startPos;
-    int endPos;
-    bool insideTag = false;
+    int startPos = 0;
+    int endPos = 0;
     bool resetToBegin = false;
-    QString word;
-
-    do {
-        do {
-            m_finder->setPosition(Gui::plainTextEditor()->getCursorPosition());
-
-            //find beginning of the word
-            startPos = m_finder->toNextBoundary();
-            //check if finished
-            if (startPos == -1) {
-                if (resetToBegin) {
-                    QMessageBox::information(this, tr("Finish"), tr("Checking document has finished."));
-                    close();
-                    return;
-                }
-                if (QMessageBox::No == QMessageBox::information(this, tr("Finish"), tr("Checking document has finished.\nDo you want to start from the beginning?"), QMessageBox::Yes, QMessageBox::No)) {
-                    close();
-                    return;
-                }
-                Gui::plainTextEditor()->setCursorPosition(0);
-                insideTag = false;
-                resetToBegin = true;
-                continue;
-            }
-            //if not start word then seek backward to find beginning
-            if (m_finder->boundaryReasons() != QTextBoundaryFinder::StartWord) {
-                //should not happen to return -1
-                startPos = m_finder->toPreviousBoundary();
-            }
-            //should not happen to return -1
-            endPos = m_finder->toNextBoundary();
 
-            //move cursor to current word
-            Gui::plainTextEditor()->setCursorPosition(endPos);
-
-            word = m_finder->string().mid(startPos, endPos - startPos);
-            //qDebug() << word;
-
-            if (word == "<") {
-                insideTag = true;
+    if (m_textDirty) {
+        reloadText();
+    }
+    m_tokenizer->setPosition(Gui::plainTextEditor()->getCursorPosition());
+    while (true) {
+        if (!m_tokenizer->nextWord(startPos, endPos)) {
+            if (resetToBegin) {
+                QMessageBox::information(this, tr("Finish"), tr("Checking document has finished."));
+                close();
+                return;
             }
-            else if (word == ">") {
-                insideTag = false;
+            if (QMessageBox::No == QMessageBox::information(this, tr("Finish"), tr("Checking document has finished.\nDo you want to start from the beginning?"), QMessageBox::Yes, QMessageBox::No)) {
+                close();
+                return;
             }
-        } while (insideTag);
-    } while (Spellcheck::instance().checkWord(word));
-    m_currentWord = word;
-    qDebug() << "not found word" << word;
+            m_tokenizer->setPosition(0);
+            resetToBegin = true;
+            continue;
+        }
+        //word is not copied, it refers to m_text
+        if (!Spellcheck::instance().checkWord(
+                QString::fromRawData(m_text.constData() + startPos, endPos - startPos),
+                m_tokenizer->language()))
+        {
+            break;
+        }
+    }
+
+    //move cursor to current word
+    Gui::plainTextEditor()->setCursorPosition(endPos);
+    m_wordStartPos = startPos;
+    m_wordEndPos = endPos;
+    m_currentWord = m_text.mid(startPos, endPos - startPos);
+    m_currentLanguage = m_tokenizer->language();
+    qDebug() << "not found word" << m_currentWord;
     fillWindow();
 }
 
@@ -201,21 +207,21 @@ void SpellCheckingWindow::loadLanguages()
 
 void SpellCheckingWindow::fillWindow()
 {
-    //Q_ASSERT(m_finder->boundaryReasons() == QTextBoundaryFinder::EndWord);
-    m_wordEndPos = m_finder->position();
-    m_finder->toPreviousBoundary();
-    m_wordStartPos = m_finder->position();
-    QTextBoundaryFinder sentence(QTextBoundaryFinder::Sentence, m_finder->string());
-    sentence.setPosition(m_wordEndPos);
+    //sentence is searched only around the word, not in whole document
+    const int contextStart = qMax(0, m_wordStartPos - SENTENCE_SEARCH_RANGE);
+    const int contextEnd = qMin(m_text.length(), m_wordEndPos + SENTENCE_SEARCH_RANGE);
+    QTextBoundaryFinder sentence(QTextBoundaryFinder::Sentence,
+            m_text.mid(contextStart, contextEnd - contextStart));
+    sentence.setPosition(m_wordEndPos - contextStart);
     sentence.toPreviousBoundary();
-    m_sentenceStartPos = sentence.position();
+    m_sentenceStartPos = contextStart + sentence.position();
     sentence.toNextBoundary();
-    m_sentenceEndPos = sentence.position();
+    m_sentenceEndPos = contextStart + sentence.position();
 
-    while (m_finder->string().at(m_sentenceEndPos - 1).isSpace() &&
+    while (m_text.at(m_sentenceEndPos - 1).isSpace() &&
            m_sentenceEndPos-- > m_sentenceStartPos) ; //do nothing
 
-    m_undoEditText = sentence.string().mid(m_sentenceStartPos,
+    m_undoEditText = m_text.mid(m_sentenceStartPos,
             m_sentenceEndPos-m_sentenceStartPos);
     m_undoEditText.insert(m_wordEndPos - m_sentenceStartPos, "</font>");
     m_undoEditText.insert(m_wordStartPos - m_sentenceStartPos, "<font color=\"red\">");
@@ -223,7 +229,7 @@ void SpellCheckingWindow::fillWindow()
     m_textContext->setHtml(m_undoEditText);
     m_textContext->blockSignals(false);
 
-    m_suggestions->setStringList(Spellcheck::instance().hints(m_currentWord));
+    m_suggestions->setStringList(Spellcheck::instance().hints(m_currentWord, m_currentLanguage));
     m_editMode = false;
     applyEditMode();
 }
@@ -272,7 +278,7 @@ void SpellCheckingWindow::addToDictionary()
 void SpellCheckingWindow::change()
 {
     if (m_editMode) {
-        qDebug() << Gui::plainTextEditor()->toPlainText().mid(m_sentenceStartPos, m_sentenceEndPos - m_sentenceStartPos) <<
+        qDebug() << Book::instance().getTextSnapshot().mid(m_sentenceStartPos, m_sentenceEndPos - m_sentenceStartPos) <<
                     "replaced by" <<
                     m_textContext->toPlainText();
         Gui::plainTextEditor()->replace(
@@ -289,7 +295,7 @@ void SpellCheckingWindow::change()
         QString replacement = m_suggestions->data(indexes.first(),
                 Qt:: DisplayRole).toString();
 
-        qDebug() << Gui::plainTextEditor()->toPlainText().mid(m_wordStartPos, m_wordEndPos - m_wordStartPos) <<
+        qDebug() << Book::instance().getTextSnapshot().mid(m_wordStartPos, m_wordEndPos - m_wordStartPos) <<
                     "replaced by" <<
                     replacement;
         Gui::plainTextEditor()->replace(
@@ -317,14 +323,25 @@ void SpellCheckingWindow::changeAll()
 
     int originalPos = Gui::plainTextEditor()->getCursorPosition() - m_currentWord.length();
 
-    QString pattern = "\\b" + m_currentWord + "\\b";
-    QRegExp rx(pattern);
-    rx.setMinimal(true);
-    int position = Gui::plainTextEditor()->toPlainText().indexOf(rx, originalPos);
+    //find all occurrences in single scan and replace them as one edit
+    if (m_textDirty) {
+        reloadText();
+    }
+    const QString text = m_text;
+    const int length = m_currentWord.length();
+    QVector<int> positions;
+    int position = text.indexOf(m_currentWord, originalPos);
     while (position != -1) {
-        Gui::plainTextEditor()->replace(position, rx.matchedLength(), replacement);
-        position = Gui::plainTextEditor()->toPlainText().indexOf(rx, position + replacement.length());
+        if (isWordBoundary(text, position) && isWordBoundary(text, position + length)) {
+            positions.push_back(position);
+            position += length;
+        }
+        else {
+            ++position;
+        }
+        position = text.indexOf(m_currentWord, position);
     }
+    Gui::plainTextEditor()->replace(positions, length, replacement);
 
     Gui::plainTextEditor()->setCursorPosition(originalPos);
     findNextWord();
@@ -335,8 +352,7 @@ void SpellCheckingWindow::showEvent(QShowEvent *event)
     Q_UNUSED(event);
     loadLanguages();
 
-    delete m_finder;
-    m_finder = new QTextBoundaryFinder(QTextBoundaryFinder::Word, Gui::plainTextEditor()->toPlainText());
+    m_textDirty = true;
 
     m_textContext->blockSignals(true);
     m_textContext->clear();
@@ -360,12 +376,18 @@ void SpellCheckingWindow::customEvent(QEvent *event)
 
 void SpellCheckingWindow::editorTextChanged()
 {
-    if (isVisible()) {
-        qDebug() << "editor text changed, recreating QTextBoundaryFinder";
-        delete m_finder;
-        m_finder = new QTextBoundaryFinder(QTextBoundaryFinder::Word,
-                Gui::plainTextEditor()->toPlainText());
-    }
+    //copying the whole text on every change is too slow, it is reloaded when needed
+    m_textDirty = true;
+}
+
+void SpellCheckingWindow::reloadText()
+{
+    //tokenizer refers to m_text, so it has to be recreated
+    delete m_tokenizer;
+    m_text = Book::instance().getText();
+    m_textDirty = false;
+    m_tokenizer = new WordTokenizer(m_text);
+    m_tokenizer->setSkipUrls(Spellcheck::instance().skipPolicy() & Spellcheck::SKIP_URLS);
 }
 
 void SpellCheckingWindow::textContextChanged()
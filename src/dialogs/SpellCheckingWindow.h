@@ -23,7 +23,6 @@
 #define BLACK_MILORD_SPELL_CHECKING_WINDOW_H
 
 #include <QDialog>
-#include <QTextBoundaryFinder>
 #include <QStringList>
 #include <QString>
 
@@ -33,6 +32,7 @@ class QListView;
 class QComboBox;
 class QShowEvent;
 class QPushButton;
+class WordTokenizer;
 
 class SpellCheckingWindow : public QDialog
 {
@@ -48,14 +48,18 @@ private:
     QStringListModel *m_suggestions;
     QListView *m_suggestionsListView;
     QComboBox *m_language;
-    QTextBoundaryFinder *m_finder;
+    WordTokenizer *m_tokenizer;
     QPushButton *m_ignoreOnceButton;
     QPushButton *m_ignoreAllButton;
     QPushButton *m_addToDictionaryButton;
     QPushButton *m_changeButton;
     QPushButton *m_changeAllButton;
 
+    QString m_text;
+    //editor text changed since m_text was loaded
+    bool m_textDirty;
     QString m_currentWord;
+    QString m_currentLanguage;
     QString m_undoEditText;
     int m_wordEndPos;
     int m_wordStartPos;
@@ -80,6 +84,7 @@ protected:
     void findNextWord();
     void fillWindow();
     void applyEditMode();
+    void reloadText();
 };
 
 #endif /* BLACK_MILORD_SPELL_CHECKING_WINDOW_H */
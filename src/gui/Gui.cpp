@@ -39,6 +39,11 @@ void Gui::setPlainTextEditor(PlainTextEditor *editor)
     m_editor = editor;
 }
 
+bool Gui::hasPlainTextEditor()
+{
+    return NULL != m_editor;
+}
+
 StatusBar* Gui::statusBar()
 {
     Q_ASSERT(NULL != m_statusBar);
@@ -50,3 +55,8 @@ void Gui::setStatusBar(StatusBar *statusBar)
     Q_ASSERT(NULL == m_statusBar || statusBar == NULL);
     m_statusBar = statusBar;
 }
+
+bool Gui::hasStatusBar()
+{
+    return NULL != m_statusBar;
+}
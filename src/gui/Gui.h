@@ -30,9 +30,11 @@ class Gui
 public:
     static PlainTextEditor* plainTextEditor();
     static void setPlainTextEditor(PlainTextEditor *editor);
+    static bool hasPlainTextEditor();
 
     static StatusBar* statusBar();
     static void setStatusBar(StatusBar *statusBar);
+    static bool hasStatusBar();
 private:
     static PlainTextEditor *m_editor;
     static StatusBar *m_statusBar;
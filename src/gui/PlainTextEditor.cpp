@@ -27,17 +27,32 @@
 #include <QApplication>
 #include <QTextCursor>
 #include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCharFormat>
+#include <QColor>
 
 #include "Gui.h"
-#include "StatusBar.h"
 #include <Spellcheck.h>
+#include <WordTokenizer.h>
 #include <HighlighterManager.h>
 #include <Book.h>
 #include <Preferences.h>
+#include <Formatting.h>
+
+namespace {
+    //first part of loaded text is shown at once, the rest is appended in the background
+    const int LOAD_CHUNK_SIZE = 64 * 1024;
+    //extra selections are slow to lay out, further search results are only listed
+    const int MAX_SEARCH_HIGHLIGHTS = 5000;
+}
 
 PlainTextEditor::PlainTextEditor(QWidget * parent) :
-    QPlainTextEdit(parent)
+    QPlainTextEdit(parent),
+    m_loadedLength(0),
+    m_reportChanges(true)
 {
+    m_loadTimer.setInterval(0);
+    connect(&m_loadTimer, SIGNAL(timeout()), this, SLOT(loadNextChunkSlot()));
     connect(&Preferences::instance(), SIGNAL(settingsChanged()), this, SLOT(applySettings()));
     connect(document(), SIGNAL(contentsChange(int, int, int)), this, SLOT(contentsChangeSlot(int, int, int)));
     connect(document(), SIGNAL(contentsChanged()), this, SLOT(contentsChangedSlot()));
@@ -61,6 +76,7 @@ int PlainTextEditor::getCursorPosition() const
 void PlainTextEditor::setCursorPosition(int position)
 {
     if (getCursorPosition() != position) {
+        ensureLoaded(position);
         QTextCursor cursor = textCursor();
         cursor.setPosition(position);
         setTextCursor(cursor);
@@ -76,6 +92,7 @@ void PlainTextEditor::setCursorPositionToStart()
 
 void PlainTextEditor::setCursorPositionToEnd()
 {
+    ensureLoaded(Book::instance().getTextLength());
     QTextCursor cursor = textCursor();
     cursor.movePosition(QTextCursor::End);
     setTextCursor(cursor);
@@ -105,6 +122,7 @@ void PlainTextEditor::setSelection(int selectionStart, int selectionEnd)
     int oldSelectionEnd = cursor.selectionEnd();
     Q_ASSERT(selectionStart >= 0 && selectionEnd >= 0);
     if (oldSelectionStart != selectionStart || oldSelectionEnd != selectionEnd) {
+        ensureLoaded(qMax(selectionStart, selectionEnd));
         cursor.setPosition(selectionStart);
         cursor.setPosition(selectionEnd, QTextCursor::KeepAnchor);
         setTextCursor(cursor);
@@ -132,6 +150,7 @@ QString PlainTextEditor::toPlainText() const
 
 void PlainTextEditor::setPlainText(const QString &text)
 {
+    ensureLoaded(Book::instance().getTextLength());
     QTextCursor cursor = textCursor();
     cursor.select(QTextCursor::Document);
     cursor.insertText(text);
@@ -140,6 +159,7 @@ void PlainTextEditor::setPlainText(const QString &text)
 void PlainTextEditor::replace(int position, int length, const QString &after)
 {
     Q_ASSERT(position >= 0);
+    ensureLoaded(position + length);
 
     QTextCursor cursor = textCursor();
     cursor.setPosition(position);
@@ -147,6 +167,149 @@ void PlainTextEditor::replace(int position, int length, const QString &after)
     cursor.insertText(after);
 }
 
+void PlainTextEditor::replace(const QVector<int> &positions, int length, const QString &after)
+{
+    if (positions.isEmpty()) {
+        return;
+    }
+    ensureLoaded(positions.last() + length);
+
+    //Positions must be sorted ascending, replacing from the end keeps remaining positions valid.
+    QVector<TextReplacement> replacements(positions.size());
+    for (int i = 0; i < positions.size(); ++i) {
+        replacements[i].position = positions[i];
+        replacements[i].length = length;
+        replacements[i].after = after;
+    }
+    replace(replacements);
+}
+
+void PlainTextEditor::replace(const QVector<TextReplacement> &replacements)
+{
+    if (replacements.isEmpty()) {
+        return;
+    }
+    ensureLoaded(replacements.last().position + replacements.last().length);
+
+    //Qt merges changes of an edit block into one contentsChange spanning all of them,
+    //so every replacement gets its own block joined to the first one for undo.
+    //Highlighting, layout and Book then update only the touched blocks.
+    QTextCursor cursor = textCursor();
+    for (int i = replacements.size() - 1; i >= 0; --i) {
+        const TextReplacement &replacement = replacements[i];
+        Q_ASSERT(replacement.position >= 0);
+        Q_ASSERT(i == 0 || replacements[i - 1].position + replacements[i - 1].length <= replacement.position);
+        if (i == replacements.size() - 1) {
+            cursor.beginEditBlock();
+        }
+        else {
+            cursor.joinPreviousEditBlock();
+        }
+        cursor.setPosition(replacement.position);
+        cursor.setPosition(replacement.position + replacement.length, QTextCursor::KeepAnchor);
+        cursor.insertText(replacement.after);
+        cursor.endEditBlock();
+    }
+}
+
+void PlainTextEditor::loadText(const PieceTable &text)
+{
+    m_loadTimer.stop();
+    m_loadedText = text;
+    m_loadedLength = 0;
+
+    //loading is not undoable, reenabling undo at the end clears the history
+    document()->setUndoRedoEnabled(false);
+    m_reportChanges = false;
+    QTextCursor cursor(document());
+    cursor.select(QTextCursor::Document);
+    cursor.removeSelectedText();
+    m_reportChanges = true;
+
+    if (appendLoadedChunk()) {
+        setReadOnly(true);
+        m_loadTimer.start();
+    }
+}
+
+bool PlainTextEditor::isLoading() const
+{
+    return m_loadedLength < m_loadedText.length();
+}
+
+bool PlainTextEditor::appendLoadedChunk()
+{
+    int length = qMin(LOAD_CHUNK_SIZE, m_loadedText.length() - m_loadedLength);
+    //do not split surrogate pairs between chunks
+    if (length > 1 && length < m_loadedText.length() - m_loadedLength &&
+        m_loadedText.at(m_loadedLength + length - 1).isHighSurrogate()) {
+        --length;
+    }
+    if (length > 0) {
+        const bool modified = isModified();
+        m_reportChanges = false;
+        QTextCursor cursor(document());
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertText(m_loadedText.mid(m_loadedLength, length));
+        m_reportChanges = true;
+        m_loadedLength += length;
+        setModified(modified);
+    }
+    if (isLoading()) {
+        return true;
+    }
+    m_loadTimer.stop();
+    m_loadedText = PieceTable();
+    m_loadedLength = 0;
+    setReadOnly(false);
+    document()->setUndoRedoEnabled(true);
+    if (!m_searchHighlights.isEmpty()) {
+        applySearchHighlights();
+    }
+    return false;
+}
+
+void PlainTextEditor::ensureLoaded(int position)
+{
+    while (document()->characterCount() - 1 < position && appendLoadedChunk()) {
+    }
+}
+
+//Search highlighting
+
+void PlainTextEditor::setSearchHighlights(const QVector<QPair<int, int> > &ranges)
+{
+    m_searchHighlights = ranges;
+    applySearchHighlights();
+}
+
+void PlainTextEditor::clearSearchHighlights()
+{
+    m_searchHighlights.clear();
+    setExtraSelections(QList<QTextEdit::ExtraSelection>());
+}
+
+void PlainTextEditor::applySearchHighlights()
+{
+    QTextCharFormat format;
+    format.setBackground(QColor(Qt::yellow));
+    const int length = document()->characterCount() - 1;
+    QList<QTextEdit::ExtraSelection> selections;
+    for (int i = 0; i < m_searchHighlights.size() && i < MAX_SEARCH_HIGHLIGHTS; ++i) {
+        const QPair<int, int> &range = m_searchHighlights[i];
+        if (range.first + range.second > length) {
+            break;
+        }
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(document());
+        selection.cursor.setPosition(range.first);
+        selection.cursor.setPosition(range.first + range.second, QTextCursor::KeepAnchor);
+        selection.format = format;
+        selections.append(selection);
+    }
+    setExtraSelections(selections);
+}
+
 //Blocks handling
 
 int PlainTextEditor::firstVisibleBlock() const
@@ -170,58 +333,6 @@ int PlainTextEditor::blockCount() const
     return QPlainTextEdit::blockCount();
 }
 
-//XML utils
-
-XMLElement PlainTextEditor::findXMLElement(const QString &element, int from) const
-{
-    XMLElement result(element);
-
-    QString pattern = "<\\s*\\b" + QRegExp::escape(element) + "\\b";
-    QRegExp rx(pattern);
-    rx.setMinimal(true);
-    rx.setCaseSensitivity(Qt::CaseInsensitive);
-
-    const QString text = toPlainText();
-
-    int start = text.indexOf(rx, from);
-    int end = text.indexOf(">", start + 1);
-    if (-1 != start && -1 != end)
-    {
-        QString elementCopy = text.mid(start + 1 + element.length(),
-                                       end - (start + 1 + element.length())).trimmed();
-
-        QRegExp attrPattern("([a-z]+)\\s*=\\s*((?:\"[^\"]*\")|(?:'[^']*'))");
-        QMap<QString, QString> attributes;
-        int attrPos = 0;
-        do
-        {
-            attrPos = elementCopy.indexOf(attrPattern, attrPos);
-            if (attrPos == -1) {
-                break;
-            }
-            QString attrName = attrPattern.cap(1);
-            QString attrValue = attrPattern.cap(2).mid(1);
-            attrValue = attrValue.left(attrValue.length() - 1);
-            attributes.insert(attrName, attrValue);
-            attrPos += attrPattern.matchedLength();
-        } while (attrPos != -1);
-
-        result.setStartPos(start);
-        result.setEndPos(end + 1);
-        result.setAttributes(attributes);
-
-//        qDebug() << "position of "
-//                 << result.elementName()
-//                 << " "
-//                 << result.startPos()
-//                 << " "
-//                 << result.endPos()
-//                 << " "
-//                 << result.attributes();
-    }
-    return result;
-}
-
 //Utils
 
 void PlainTextEditor::setFocus()
@@ -296,8 +407,21 @@ void PlainTextEditor::contextMenuEvent(QContextMenuEvent * event)
             cursor = cursorForPosition(event->pos());
             setTextCursor(cursor);
             cursor.select(QTextCursor::WordUnderCursor);
-            if (!Spellcheck::instance().checkWord(cursor.selectedText())) {
-                const QStringList &hints = Spellcheck::instance().hints(cursor.selectedText());
+            //language of the word as the highlighter sees it
+            const QString blockText = cursor.block().text();
+            const int selectionStart = cursor.selectionStart() - cursor.block().position();
+            WordTokenizer tokenizer(blockText);
+            tokenizer.setSkipUrls(Spellcheck::instance().skipPolicy() & Spellcheck::SKIP_URLS);
+            int wordStart = -1;
+            int wordEnd = -1;
+            //tokenize from the block start, the word may be part of an address
+            while (wordEnd <= selectionStart && tokenizer.nextWord(wordStart, wordEnd)) ;
+            const QString language = tokenizer.language();
+            //words of addresses and markup are not checked
+            if (wordStart == selectionStart &&
+                !Spellcheck::instance().checkWord(cursor.selectedText(), language))
+            {
+                const QStringList &hints = Spellcheck::instance().hints(cursor.selectedText(), language);
                 if (hints.size() > 0) {
                     connect(menu, SIGNAL(triggered(QAction*)), SLOT(applyHintSlot(QAction *)));
                     menu->addSeparator();
@@ -343,6 +467,10 @@ void PlainTextEditor::undo()
 
 void PlainTextEditor::clearRedoUndoHistory()
 {
+    if (isLoading()) {
+        //history is disabled while loading and cleared when it is finished
+        return;
+    }
 #if (QT_VERSION < QT_VERSION_CHECK(4, 7, 0))
     //At this moment function is called only after closing and openning document.
     //It may require to store more information like cursor position.
@@ -368,15 +496,42 @@ void PlainTextEditor::updateRequestSlot(const QRect &rect, int dy)
 
 void PlainTextEditor::contentsChangedSlot()
 {
-    Gui::statusBar()->setStatusBarDocLength(QString::number(toPlainText().size()));
     emit contentsChanged();
 }
 
 void PlainTextEditor::contentsChangeSlot(int position, int charsRemoved, int charsAdded)
 {
+    if (!m_reportChanges) {
+        emit contentsChange(position, charsRemoved, charsAdded);
+        return;
+    }
+    //Counts reported by the document may include the final block separator
+    //which is not a part of the text, so they are recomputed from lengths.
+    //Text which is still being loaded follows the document in Book.
+    Book &book = Book::instance();
+    const int documentLength = document()->characterCount() - 1;
+    const int pendingLength = m_loadedText.length() - m_loadedLength;
+    const int added = qMax(0, qMin(position + charsAdded, documentLength) - position);
+    const int removed = book.getTextLength() - pendingLength + added - documentLength;
+    Q_ASSERT(removed >= 0);
+
+    QString addedText;
+    if (added > 0) {
+        QTextCursor cursor(document());
+        cursor.setPosition(position);
+        cursor.setPosition(position + added, QTextCursor::KeepAnchor);
+        addedText = Formatting::normalizeEditorText(cursor.selectedText());
+    }
+    book.updateText(position, removed, addedText);
+
     emit contentsChange(position, charsRemoved, charsAdded);
 }
 
+void PlainTextEditor::loadNextChunkSlot()
+{
+    appendLoadedChunk();
+}
+
 void PlainTextEditor::applyHintSlot(QAction *action)
 {
     if (!action->data().isNull()) {
@@ -23,9 +23,13 @@
 #define BLACK_MILORD_PLAIN_TEXT_EDITOR_H
 
 #include <QPlainTextEdit>
-#include <XMLElement.h>
+#include <QVector>
+#include <QPair>
+#include <QTimer>
+#include <PieceTable.h>
 
 class QLayout;
+struct TextReplacement;
 
 class PlainTextEditor :
     protected QPlainTextEdit
@@ -54,6 +58,24 @@ public:
     QString toPlainText() const;
     void setPlainText(const QString &text);
     void replace(int position, int length, const QString &after);
+    void replace(const QVector<int> &positions, int length, const QString &after);
+    void replace(const QVector<TextReplacement> &replacements);
+    /**
+     * Replaces the whole text without reporting it back to Book.
+     * Only the beginning is inserted at once, the rest is appended in the background.
+     * Editor is read only until loading is finished.
+     */
+    void loadText(const PieceTable &text);
+    bool isLoading() const;
+
+    //Search highlighting
+    /**
+     * Marks ranges given as position and length, previous marks are removed.
+     * Marks follow later edits of the text. Ranges which are not loaded yet
+     * are marked when loading is finished.
+     */
+    void setSearchHighlights(const QVector<QPair<int, int> > &ranges);
+    void clearSearchHighlights();
 
     //Blocks handling
     int firstVisibleBlock() const;
@@ -61,9 +83,6 @@ public:
     QTextBlock findBlockByNumber(int blockNumber) const;
     int blockCount() const;
 
-    //XML utils
-    XMLElement findXMLElement(const QString &element, int from = 0) const;
-
     //Utils
     void setFocus();
 
@@ -98,6 +117,19 @@ private slots:
     void contentsChangedSlot();
     void contentsChangeSlot(int position, int charsRemoved, int charsAdded);
     void applyHintSlot(QAction *action);
+    void loadNextChunkSlot();
+
+private:
+    bool appendLoadedChunk();
+    void ensureLoaded(int position);
+    void applySearchHighlights();
+
+    //text which is being loaded and length of the part already in the document
+    PieceTable m_loadedText;
+    int m_loadedLength;
+    QTimer m_loadTimer;
+    bool m_reportChanges;
+    QVector<QPair<int, int> > m_searchHighlights;
 };
 
 #endif /* BLACK_MILORD_PLAIN_TEXT_EDITOR_H */
\ No newline at end of file
@@ -21,27 +21,57 @@
 
 #include "StatusBar.h"
 #include <QLabel>
+#include <Book.h>
+
+namespace {
+    const int UPDATE_INTERVAL = 16;
+}
 
 StatusBar::StatusBar(QWidget *parent) :
     QStatusBar(parent),
-    m_statusBarDocLength(new QLabel())
+    m_statusBarDocLength(new QLabel()),
+    m_statusBarWordCount(new QLabel()),
+    m_statusBarEncodedSize(new QLabel())
 {
+    addPermanentWidget(m_statusBarWordCount);
+    addPermanentWidget(m_statusBarEncodedSize);
     addPermanentWidget(m_statusBarDocLength);
-    m_statusBarDocLength->setText("0");
     m_statusBarDocLength->setMinimumWidth(30);
     m_statusBarDocLength->setAlignment(Qt::AlignRight);
+    m_statusBarDocLength->setToolTip(tr("Number of characters"));
+    m_statusBarWordCount->setAlignment(Qt::AlignRight);
+    m_statusBarEncodedSize->setAlignment(Qt::AlignRight);
+    m_statusBarEncodedSize->setToolTip(tr("Size of the text in the saved file"));
+
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(UPDATE_INTERVAL);
+    connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(updateTextStatisticsSlot()));
+    connect(&Book::instance(), SIGNAL(textChanged()), this, SLOT(textChangedSlot()));
+    updateTextStatisticsSlot();
 }
 
 StatusBar::~StatusBar()
 {
 }
 
-void StatusBar::setStatusBarDocLength(const QString &length)
+void StatusBar::showMessage(const QString &message, int timeout)
 {
-    m_statusBarDocLength->setText(length);
+    QStatusBar::showMessage(message, timeout);
 }
 
-void StatusBar::showMessage(const QString &message, int timeout)
+void StatusBar::textChangedSlot()
 {
-    QStatusBar::showMessage(message, timeout);
-}
\ No newline at end of file
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+void StatusBar::updateTextStatisticsSlot()
+{
+    const TextStatistics &statistics = Book::instance().getTextStatistics();
+    m_statusBarDocLength->setText(QString::number(Book::instance().getTextLength()));
+    m_statusBarWordCount->setText(tr("%1 words").arg(statistics.wordCount()));
+    m_statusBarEncodedSize->setText(tr("%1 KB, %2 records")
+        .arg((statistics.encodedSize() + 1023) / 1024)
+        .arg(statistics.recordCount()));
+}
@@ -23,6 +23,7 @@
 #define BLACK_MILORD_STATUS_BAR_H
 
 #include <QStatusBar>
+#include <QTimer>
 
 class QLabel;
 class QString;
@@ -30,18 +31,24 @@ class QString;
 class StatusBar :
     public QStatusBar
 {
+    Q_OBJECT
 public:
     explicit StatusBar(QWidget * parent = 0);
     virtual ~StatusBar();
 
-    void setStatusBarDocLength(const QString &length);
-
 public slots:
     void showMessage(const QString &message, int timeout = 2000);
 
+private slots:
+    void textChangedSlot();
+    void updateTextStatisticsSlot();
+
 private:
     QLabel *m_statusBarDocLength;
-
+    QLabel *m_statusBarWordCount;
+    QLabel *m_statusBarEncodedSize;
+    //statistics are shown at most once per frame
+    QTimer m_updateTimer;
 };
 
 #endif /* BLACK_MILORD_STATUS_BAR_H */
@@ -29,7 +29,8 @@ DeviceConfiguration& DeviceConfiguration::instance()
     return instance;
 }
 
-DeviceConfiguration::DeviceConfiguration()
+DeviceConfiguration::DeviceConfiguration() :
+    m_screenSize(600, 800)
 {
     QFile file(":/kindle3/HtmlValidation.def");
      if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -54,3 +55,8 @@ QStringList DeviceConfiguration::getValidHTMLTags() const
 {
     return m_validHTMLTags;
 }
+
+QSize DeviceConfiguration::getScreenSize() const
+{
+    return m_screenSize;
+}
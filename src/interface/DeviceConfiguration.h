@@ -23,6 +23,7 @@
 #define BLACK_MILORD_DEVICE_CONFIGURATION_H
 
 #include <QStringList>
+#include <QSize>
 
 class DeviceConfiguration
 {
@@ -34,9 +35,12 @@ public:
     static DeviceConfiguration& instance();
 
     QStringList getValidHTMLTags() const;
+    //pictures larger than the screen are scaled down
+    QSize getScreenSize() const;
 
 private:
     QStringList m_validHTMLTags;
+    QSize m_screenSize;
 };
 
 
@@ -39,6 +39,8 @@ QString bookMetaDataLabel(MetaData metadata)
         return QObject::tr("ISBN");
     case METADATA_SUBJECT:
         return QObject::tr("Subject");
+    case METADATA_LANGUAGE:
+        return QObject::tr("Language");
     case METADATA_VERSION:
         return QObject::tr("Version");
     case METADATA_CREATION_DATE:
@@ -49,6 +51,12 @@ QString bookMetaDataLabel(MetaData metadata)
         return QObject::tr("Last backup date");
     case METADATA_MODIFICATION_NUMBER:
         return QObject::tr("Modification number");
+    case METADATA_EXTH_RECORDS:
+        return QObject::tr("EXTH records");
+    case METADATA_COVER_PICTURE:
+        return QObject::tr("Cover picture");
+    case METADATA_THUMBNAIL_PICTURE:
+        return QObject::tr("Thumbnail picture");
     default:
         break;
     }
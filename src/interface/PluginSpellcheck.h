@@ -40,15 +40,23 @@ public:
     }
 
     virtual bool isLoaded() const = 0;
-    virtual bool checkWord(const QString &word) const = 0;
+
+    /**
+     * Checks word using dictionary of given language.
+     * Dictionaries once loaded are kept, so checking text
+     * in several languages does not reload them.
+     * @param language Language code as returned by availableLanguages(),
+     *                 empty string means current language.
+     */
+    virtual bool checkWord(const QString &word, const QString &language) const = 0;
     virtual bool addWordToSessionDictionary(const QString &word) = 0;
     virtual bool addWordToPersonalDictionary(const QString &word) = 0;
-    virtual QStringList hints(const QString &word) const = 0;
+    virtual QStringList hints(const QString &word, const QString &language) const = 0;
     virtual QString language() const = 0;
     virtual QList<QPair<QString, QString> > availableLanguages() const = 0;
     virtual void changeLanguage(const QString &code) = 0;
 };
 
-Q_DECLARE_INTERFACE(PluginSpellcheck, "org.blackmilord.Plugin.Spellcheck/1.0");
+Q_DECLARE_INTERFACE(PluginSpellcheck, "org.blackmilord.Plugin.Spellcheck/1.1");
 
 #endif /* BLACK_MILORD_PLUGIN_SPELLCHECK_H */
@@ -35,6 +35,7 @@ namespace {
     const QString PROP_VERSION                      = "core/version";
     const QString PROP_MAKE_BACKUP_BEFORE_OVERWRITE = "core/backup_before_overwrite";
     const QString PROP_ASPELL_DICTIONARY            = "core/aspell_language";
+    const QString PROP_SPELLCHECK_SKIP_POLICY       = "core/spellcheck_skip_policy";
     const QString PROP_LAST_USED_DIRECTORY          = "core/last_dir";
     const QString PROP_WINDOW_WIDTH                 = "window/width";
     const QString PROP_WINDOW_HEIGHT                = "window/height";
@@ -53,6 +54,11 @@ double Preferences::getVersion() const
     return m_settings->value(PROP_VERSION, 0.0).toDouble();
 }
 
+QString Preferences::getConfigDirectory() const
+{
+    return m_configDirectory;
+}
+
 void Preferences::setMakeBackupBeforeOverwrite(bool makeBackup)
 {
     Q_ASSERT(m_threadGuard == QThread::currentThread());
@@ -77,6 +83,18 @@ QString Preferences::getAspellDictionary() const
     return m_settings->value(PROP_ASPELL_DICTIONARY, "").toString();
 }
 
+void Preferences::setSpellcheckSkipPolicy(int policy)
+{
+    Q_ASSERT(m_threadGuard == QThread::currentThread());
+    m_settings->setValue(PROP_SPELLCHECK_SKIP_POLICY, policy);
+}
+
+int Preferences::getSpellcheckSkipPolicy(int defPolicy) const
+{
+    Q_ASSERT(m_threadGuard == QThread::currentThread());
+    return m_settings->value(PROP_SPELLCHECK_SKIP_POLICY, defPolicy).toInt();
+}
+
 void Preferences::setWindowWidth(int width)
 {
     Q_ASSERT(m_threadGuard == QThread::currentThread());
@@ -219,14 +237,14 @@ Preferences& Preferences::instance()
 Preferences::Preferences() :
     m_threadGuard(QThread::currentThread())
 {
-    QString configFile;
 #if (defined Q_WS_X11 || defined Q_WS_MAC)
-    configFile = getenv("HOME");
-    configFile.append( "/.blackmilord/config.ini");
+    m_configDirectory = getenv("HOME");
+    m_configDirectory.append("/.blackmilord");
 #elif defined Q_WS_WIN
-    configFile = getenv("APPDATA");
-    configFile.append( "\\BlackMilord\\config.ini");
+    m_configDirectory = getenv("APPDATA");
+    m_configDirectory.append("\\BlackMilord");
 #endif
+    QString configFile = QDir(m_configDirectory).absoluteFilePath("config.ini");
     qDebug() << "Using config file" << configFile;
     bool needDefault = !QFile::exists(configFile);
     m_settings = new QSettings(configFile, QSettings::IniFormat);
@@ -44,12 +44,17 @@ public:
 
     double getVersion() const;
 
+    QString getConfigDirectory() const;
+
     void setMakeBackupBeforeOverwrite(bool makeBackup);
     bool getMakeBackupBeforeOverwrite() const;
 
     void setAspellDictionary(const QString &dictionary);
     QString getAspellDictionary() const;
 
+    void setSpellcheckSkipPolicy(int policy);
+    int getSpellcheckSkipPolicy(int defPolicy = 0) const;
+
     void setWindowWidth(int width);
     int getWindowWidth(int defWidth = 0) const;
 
@@ -83,6 +88,7 @@ private:
 
     QThread *m_threadGuard;
     QSettings *m_settings;
+    QString m_configDirectory;
 
 signals:
     void settingsChanged();
@@ -24,10 +24,106 @@
 #include <QDir>
 #include <QPluginLoader>
 #include <QApplication>
+#include <QMutexLocker>
 #include "PluginSpellcheck.h"
+#include "Preferences.h"
+
+namespace {
+    enum CharacterClass {
+        CLASS_LOWER = 0x01,
+        CLASS_UPPER = 0x02,
+        CLASS_OTHER_LETTER = 0x04,
+        CLASS_DIGIT = 0x08,
+        CLASS_SYMBOL = 0x10,
+        //uppercase IVXLCDM
+        CLASS_ROMAN = 0x20,
+        CLASS_LETTER = CLASS_LOWER | CLASS_UPPER | CLASS_OTHER_LETTER
+    };
+
+    inline uchar classOfCategory(QChar::Category category)
+    {
+        switch (category) {
+        case QChar::Letter_Lowercase:
+            return CLASS_LOWER;
+        case QChar::Letter_Uppercase:
+        case QChar::Letter_Titlecase:
+            return CLASS_UPPER;
+        case QChar::Letter_Modifier:
+        case QChar::Letter_Other:
+        case QChar::Mark_NonSpacing:
+        case QChar::Mark_SpacingCombining:
+        case QChar::Mark_Enclosing:
+            return CLASS_OTHER_LETTER;
+        case QChar::Number_DecimalDigit:
+        case QChar::Number_Letter:
+        case QChar::Number_Other:
+            return CLASS_DIGIT;
+        default:
+            return CLASS_SYMBOL;
+        }
+    }
+
+    class CharacterClassTable
+    {
+    public:
+        CharacterClassTable()
+        {
+            for (int c = 0; c < 256; ++c) {
+                m_class[c] = classOfCategory(QChar(c).category());
+            }
+            const char roman[] = "IVXLCDM";
+            for (int i = 0; roman[i]; ++i) {
+                m_class[static_cast<uchar>(roman[i])] |= CLASS_ROMAN;
+            }
+        }
+
+        inline uchar classOf(QChar c) const
+        {
+            return c.unicode() < 256 ? m_class[c.unicode()] :
+                   c.isSurrogate() ? CLASS_OTHER_LETTER : classOfCategory(c.category());
+        }
+
+    private:
+        uchar m_class[256];
+    };
+
+    const CharacterClassTable CHARACTER_CLASS_TABLE;
+
+    inline int skipRepeated(const QChar *text, int length, int i, char c, int max)
+    {
+        for (int count = 0; i < length && count < max && text[i].unicode() == c; ++count) {
+            ++i;
+        }
+        return i;
+    }
+
+    //one decimal place, e.g. IX, IV, VIII
+    inline int skipRomanDigit(const QChar *text, int length, int i, char one, char five, char ten)
+    {
+        if (i + 1 < length && text[i].unicode() == one &&
+            (text[i + 1].unicode() == five || text[i + 1].unicode() == ten))
+        {
+            return i + 2;
+        }
+        if (i < length && text[i].unicode() == five) {
+            ++i;
+        }
+        return skipRepeated(text, length, i, one, 3);
+    }
+
+    bool isRomanNumeral(const QChar *text, int length)
+    {
+        int i = skipRepeated(text, length, 0, 'M', 4);
+        i = skipRomanDigit(text, length, i, 'C', 'D', 'M');
+        i = skipRomanDigit(text, length, i, 'X', 'L', 'C');
+        i = skipRomanDigit(text, length, i, 'I', 'V', 'X');
+        return length > 0 && i == length;
+    }
+}
 
 Spellcheck::Spellcheck() :
-    m_instance(NULL)
+    m_instance(NULL),
+    m_skipPolicy(Preferences::instance().getSpellcheckSkipPolicy(SKIP_DEFAULT))
 {
     QDir pluginsDir(qApp->applicationDirPath());
     PluginSpellcheck *spellcheck;
@@ -40,9 +136,14 @@ Spellcheck::Spellcheck() :
             spellcheck = qobject_cast<PluginSpellcheck*>(plugin);
             if (spellcheck)
             {
-                m_instance = spellcheck;
                 qDebug() << "Loading spellcheck from " << pluginsDir.absolutePath() << fileName << "OK";
-                break;
+                // keep looking when a backend has no usable dictionary
+                if (!m_instance || !m_instance->isLoaded()) {
+                    m_instance = spellcheck;
+                }
+                if (m_instance->isLoaded()) {
+                    break;
+                }
             }
             else
             {
@@ -75,27 +176,48 @@ bool Spellcheck::isLoaded() const
 }
 
 bool Spellcheck::checkWord(const QString &word) const
+{
+    return checkWord(word, QString());
+}
+
+bool Spellcheck::checkWord(const QString &word, const QString &language) const
 {
     Q_ASSERT(isLoaded());
-    if (1 == word.length())
-    {
-        if (0 == word.compare(".") ||
-            0 == word.compare(",") ||
-            0 == word.compare("!") ||
-            0 == word.compare("?") ||
-            0 == word.compare(" ") ||
-            0 == word.compare("<") ||
-            0 == word.compare(">"))
-        {
-            return true;
+    if (isSkipped(word)) {
+        return true;
+    }
+    return m_instance->checkWord(word, resolveLanguage(language));
+}
+
+bool Spellcheck::isSkipped(const QString &word) const
+{
+    const int policy = m_skipPolicy;
+    const QChar *text = word.constData();
+    const int length = word.length();
+    int anyClass = 0;
+    int allClasses = ~0;
+    for (int i = 0; i < length; ++i) {
+        const int characterClass = CHARACTER_CLASS_TABLE.classOf(text[i]);
+        anyClass |= characterClass;
+        allClasses &= characterClass;
+    }
+    if (!(anyClass & (CLASS_LETTER | CLASS_DIGIT))) {
+        //empty word, punctuation
+        return 0 != (policy & SKIP_SYMBOLS);
+    }
+    if (anyClass & CLASS_DIGIT) {
+        if (!(anyClass & CLASS_LETTER)) {
+            return 0 != (policy & SKIP_NUMBERS);
         }
+        return 0 != (policy & SKIP_WORDS_WITH_DIGITS);
     }
-    bool ok = false;
-    word.toInt(&ok, 10);
-    if (ok) {
+    if ((policy & SKIP_ROMAN_NUMERALS) && (allClasses & CLASS_ROMAN) && isRomanNumeral(text, length)) {
         return true;
     }
-    return m_instance->checkWord(word);
+    if ((policy & SKIP_ALL_CAPS) && length > 1 && !(anyClass & CLASS_LOWER) && (anyClass & CLASS_UPPER)) {
+        return true;
+    }
+    return false;
 }
 
 bool Spellcheck::addWordToSessionDictionary(const QString &word)
@@ -113,7 +235,13 @@ bool Spellcheck::addWordToPersonalDictionary(const QString &word)
 QStringList Spellcheck::hints(const QString &word) const
 {
     Q_ASSERT(isLoaded());
-    return m_instance->hints(word);
+    return m_instance->hints(word, resolveLanguage(QString()));
+}
+
+QStringList Spellcheck::hints(const QString &word, const QString &language) const
+{
+    Q_ASSERT(isLoaded());
+    return m_instance->hints(word, resolveLanguage(language));
 }
 
 QString Spellcheck::language() const
@@ -133,3 +261,86 @@ void Spellcheck::changeLanguage(const QString &code)
     Q_ASSERT(isLoaded());
     m_instance->changeLanguage(code);
 }
+
+void Spellcheck::setDocumentLanguage(const QString &language)
+{
+    QMutexLocker lock(&m_mutex);
+    if (language != m_documentLanguage) {
+        m_documentLanguage = language;
+        m_resolvedLanguages.clear();
+    }
+}
+
+QString Spellcheck::documentLanguage() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_documentLanguage;
+}
+
+QString Spellcheck::resolveLanguage(const QString &language) const
+{
+    QMutexLocker lock(&m_mutex);
+    QString requested = language.isEmpty() ? m_documentLanguage : language;
+    if (requested.isEmpty()) {
+        return QString();
+    }
+    QHash<QString, QString>::const_iterator it = m_resolvedLanguages.find(requested);
+    if (it != m_resolvedLanguages.end()) {
+        return it.value();
+    }
+
+    QString result = matchDictionary(requested);
+    if (result.isEmpty() && !language.isEmpty() && !m_documentLanguage.isEmpty()) {
+        //no dictionary for the span, check it as the rest of the book
+        it = m_resolvedLanguages.find(m_documentLanguage);
+        if (it != m_resolvedLanguages.end()) {
+            result = it.value();
+        }
+        else {
+            result = matchDictionary(m_documentLanguage);
+            m_resolvedLanguages.insert(m_documentLanguage, result);
+        }
+    }
+    m_resolvedLanguages.insert(requested, result);
+    return result;
+}
+
+QString Spellcheck::matchDictionary(const QString &language) const
+{
+    if (m_availableCodes.isEmpty()) {
+        const QList<QPair<QString, QString> > &available = m_instance->availableLanguages();
+        for (int i = 0; i < available.size(); ++i) {
+            m_availableCodes.push_back(available[i].second);
+        }
+    }
+    //en-GB -> en_GB -> en -> en_US
+    QString code = language.trimmed();
+    code.replace('-', '_');
+    QString base = code.section('_', 0, 0);
+    QString result;
+    foreach (const QString &available, m_availableCodes) {
+        if (0 == available.compare(code, Qt::CaseInsensitive)) {
+            return available;
+        }
+    }
+    foreach (const QString &available, m_availableCodes) {
+        if (0 == available.compare(base, Qt::CaseInsensitive)) {
+            return available;
+        }
+        if (result.isEmpty() && available.startsWith(base + "_", Qt::CaseInsensitive)) {
+            result = available;
+        }
+    }
+    return result;
+}
+
+void Spellcheck::setSkipPolicy(int policy)
+{
+    m_skipPolicy = policy;
+    Preferences::instance().setSpellcheckSkipPolicy(policy);
+}
+
+int Spellcheck::skipPolicy() const
+{
+    return m_skipPolicy;
+}
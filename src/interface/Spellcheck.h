@@ -26,6 +26,9 @@
 #include <QString>
 #include <QList>
 #include <QPair>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
 #include <PluginSpellcheck.h>
 
 class Spellcheck
@@ -33,21 +36,62 @@ class Spellcheck
     Spellcheck();
     virtual ~Spellcheck();
 public:
+    /**
+     * Kinds of words accepted without asking the dictionary.
+     */
+    enum SkipPolicy {
+        SKIP_NUMBERS = 0x01,
+        SKIP_ROMAN_NUMERALS = 0x02,
+        SKIP_URLS = 0x04,
+        SKIP_ALL_CAPS = 0x08,
+        SKIP_SYMBOLS = 0x10,
+        SKIP_WORDS_WITH_DIGITS = 0x20,
+        SKIP_DEFAULT = SKIP_NUMBERS | SKIP_ROMAN_NUMERALS | SKIP_URLS |
+                       SKIP_SYMBOLS | SKIP_WORDS_WITH_DIGITS
+    };
+
     static Spellcheck& instance();
 
     bool isLoaded() const;
     bool checkWord(const QString &word) const;
+    /**
+     * @param language Language of the text the word comes from (lang attribute),
+     *        document language is used when empty or not available.
+     */
+    bool checkWord(const QString &word, const QString &language) const;
     bool addWordToSessionDictionary(const QString &word);
     bool addWordToPersonalDictionary(const QString &word);
     QStringList hints(const QString &word) const;
+    QStringList hints(const QString &word, const QString &language) const;
     QString language() const;
     QList<QPair<QString, QString> > availableLanguages() const;
 
+    /**
+     * Language of the opened book, e.g. from its metadata.
+     * Used for words without language of their own, does not change
+     * language selected in preferences.
+     */
+    void setDocumentLanguage(const QString &language);
+    QString documentLanguage() const;
+
+    void setSkipPolicy(int policy);
+    int skipPolicy() const;
+
 public slots:
     void changeLanguage(const QString &code);
 
 private:
+    QString resolveLanguage(const QString &language) const;
+    //dictionary code best matching the language, m_mutex must be locked
+    QString matchDictionary(const QString &language) const;
+    bool isSkipped(const QString &word) const;
+
     PluginSpellcheck *m_instance;
+    QAtomicInt m_skipPolicy;
+    mutable QMutex m_mutex;
+    QString m_documentLanguage;
+    mutable QStringList m_availableCodes;
+    mutable QHash<QString, QString> m_resolvedLanguages;
 };
 
 
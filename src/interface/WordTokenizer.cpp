@@ -0,0 +1,454 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "WordTokenizer.h"
+
+namespace {
+    //Longest entity name used in HTML is shorter than that.
+    const int MAX_ENTITY_LENGTH = 32;
+
+    class AsciiWordTable
+    {
+    public:
+        AsciiWordTable()
+        {
+            for (int c = 0; c < 128; ++c) {
+                m_word[c] = (c >= 'a' && c <= 'z') ||
+                            (c >= 'A' && c <= 'Z') ||
+                            (c >= '0' && c <= '9') ||
+                            c == '_';
+            }
+        }
+
+        inline bool isWordCharacter(ushort c) const
+        {
+            return m_word[c];
+        }
+
+    private:
+        bool m_word[128];
+    };
+
+    const AsciiWordTable ASCII_WORD_TABLE;
+
+    inline bool isWordCategory(QChar::Category category)
+    {
+        return (category >= QChar::Mark_NonSpacing && category <= QChar::Number_Other) ||
+               (category >= QChar::Letter_Uppercase && category <= QChar::Letter_Other);
+    }
+
+    inline bool isApostrophe(ushort c)
+    {
+        return c == '\'' || c == 0x2019;
+    }
+
+    inline bool isNameCharacter(ushort c)
+    {
+        return c < 128 && (ASCII_WORD_TABLE.isWordCharacter(c) || c == ':' || c == '-' || c == '.');
+    }
+
+    inline bool isSpace(ushort c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    //scheme or local part of an e-mail address
+    inline bool isUrlPrefixCharacter(ushort c)
+    {
+        return c < 128 && (ASCII_WORD_TABLE.isWordCharacter(c) || c == '.' || c == '-' || c == '+' || c == '%');
+    }
+
+    inline bool equalsIgnoreCase(const QChar *text, int length, const char *name)
+    {
+        int i = 0;
+        for (; i < length && name[i]; ++i) {
+            ushort c = text[i].unicode();
+            if (c >= 'A' && c <= 'Z') {
+                c += 'a' - 'A';
+            }
+            if (c != static_cast<uchar>(name[i])) {
+                return false;
+            }
+        }
+        return i == length && !name[i];
+    }
+
+    //elements which never have closing tag
+    inline bool isVoidElement(const QChar *name, int length)
+    {
+        static const char *const VOID_ELEMENTS[] = {
+            "br", "hr", "img", "meta", "link", "input", "col", "area", "base", "param", "mbp:pagebreak", NULL
+        };
+        for (int i = 0; VOID_ELEMENTS[i]; ++i) {
+            if (equalsIgnoreCase(name, length, VOID_ELEMENTS[i])) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+WordTokenizer::WordTokenizer(const QString &text) :
+    m_text(text.constData()),
+    m_length(text.length()),
+    m_position(0),
+    m_insideTag(false),
+    m_quote(0),
+    m_skipUrls(false)
+{
+}
+
+WordTokenizer::WordTokenizer(const QChar *text, int length) :
+    m_text(text),
+    m_length(length),
+    m_position(0),
+    m_insideTag(false),
+    m_quote(0),
+    m_skipUrls(false)
+{
+}
+
+void WordTokenizer::setSkipUrls(bool skip)
+{
+    m_skipUrls = skip;
+}
+
+void WordTokenizer::setPosition(int position)
+{
+    Q_ASSERT(position >= 0 && position <= m_length);
+    //move back to the beginning of the word
+    while (position > 0 && position < m_length &&
+           wordCharacterLength(position - 1) != 0 &&
+           wordCharacterLength(position) != 0)
+    {
+        --position;
+    }
+    if (position < m_position) {
+        m_position = 0;
+        m_insideTag = false;
+        m_quote = 0;
+        m_scopes.clear();
+    }
+    //follow markup up to the position to know tag state and language
+    while (m_position < position) {
+        ushort c = m_text[m_position].unicode();
+        if (m_insideTag) {
+            if (m_quote != 0) {
+                if (c == m_quote) {
+                    m_quote = 0;
+                }
+            }
+            else if (c == '"' || c == '\'') {
+                m_quote = c;
+            }
+            else if (c == '>') {
+                m_insideTag = false;
+            }
+            ++m_position;
+        }
+        else if (c == '<') {
+            skipTag();
+        }
+        else {
+            ++m_position;
+        }
+    }
+}
+
+int WordTokenizer::position() const
+{
+    return m_position;
+}
+
+bool WordTokenizer::nextWord(int &start, int &end)
+{
+    while (m_position < m_length) {
+        ushort c = m_text[m_position].unicode();
+        if (m_insideTag) {
+            if (m_quote != 0) {
+                if (c == m_quote) {
+                    m_quote = 0;
+                }
+            }
+            else if (c == '"' || c == '\'') {
+                m_quote = c;
+            }
+            else if (c == '>') {
+                m_insideTag = false;
+            }
+            ++m_position;
+            continue;
+        }
+        if (c == '<') {
+            skipTag();
+            continue;
+        }
+        if (c == '&') {
+            skipEntity();
+            continue;
+        }
+        int length = wordCharacterLength(m_position);
+        if (length == 0) {
+            ++m_position;
+            continue;
+        }
+        if (m_skipUrls) {
+            int end = urlEnd(m_position);
+            if (end != m_position) {
+                m_position = end;
+                continue;
+            }
+        }
+        start = m_position;
+        m_position += length;
+        while (m_position < m_length) {
+            length = wordCharacterLength(m_position);
+            if (length != 0) {
+                m_position += length;
+            }
+            else if (isApostrophe(m_text[m_position].unicode()) &&
+                     m_position + 1 < m_length &&
+                     wordCharacterLength(m_position + 1) != 0)
+            {
+                //don't, rock'n'roll
+                ++m_position;
+            }
+            else {
+                break;
+            }
+        }
+        end = m_position;
+        return true;
+    }
+    return false;
+}
+
+QString WordTokenizer::language() const
+{
+    return m_scopes.isEmpty() ? QString() : m_scopes.last().language;
+}
+
+int WordTokenizer::wordCharacterLength(int position) const
+{
+    ushort c = m_text[position].unicode();
+    if (c < 128) {
+        return ASCII_WORD_TABLE.isWordCharacter(c) ? 1 : 0;
+    }
+    if (m_text[position].isHighSurrogate()) {
+        if (position + 1 < m_length && m_text[position + 1].isLowSurrogate()) {
+            uint ucs4 = QChar::surrogateToUcs4(m_text[position], m_text[position + 1]);
+            return isWordCategory(QChar::category(ucs4)) ? 2 : 0;
+        }
+        return 0;
+    }
+    return isWordCategory(m_text[position].category()) ? 1 : 0;
+}
+
+void WordTokenizer::skipEntity()
+{
+    Q_ASSERT(m_text[m_position].unicode() == '&');
+    int end = m_position + 1;
+    int limit = qMin(m_length, end + MAX_ENTITY_LENGTH);
+    if (end < limit && m_text[end].unicode() == '#') {
+        ++end;
+    }
+    while (end < limit) {
+        ushort c = m_text[end].unicode();
+        if (c == ';') {
+            //&amp; &#160; &#xA0;
+            m_position = end + 1;
+            return;
+        }
+        if (c >= 128 || !ASCII_WORD_TABLE.isWordCharacter(c)) {
+            break;
+        }
+        ++end;
+    }
+    //not an entity, skip ampersand only
+    ++m_position;
+}
+
+int WordTokenizer::urlEnd(int position) const
+{
+    int i = position;
+    while (i < m_length && isUrlPrefixCharacter(m_text[i].unicode())) {
+        ++i;
+    }
+    bool url = false;
+    if (i + 2 < m_length && m_text[i].unicode() == ':' &&
+        m_text[i + 1].unicode() == '/' && m_text[i + 2].unicode() == '/')
+    {
+        //http://
+        url = true;
+    }
+    else if (i + 1 < m_length && m_text[i].unicode() == '@' && wordCharacterLength(i + 1) != 0) {
+        //user@host
+        url = true;
+    }
+    else if (i - position > 4 && equalsIgnoreCase(m_text + position, 4, "www.")) {
+        url = true;
+    }
+    if (!url) {
+        return position;
+    }
+    while (i < m_length) {
+        ushort c = m_text[i].unicode();
+        if (isSpace(c) || c == '<' || c == '>' || c == '"' || c == '\'') {
+            break;
+        }
+        ++i;
+    }
+    return i;
+}
+
+void WordTokenizer::skipTag()
+{
+    Q_ASSERT(m_text[m_position].unicode() == '<');
+    int i = m_position + 1;
+    bool closing = false;
+    if (i < m_length && m_text[i].unicode() == '/') {
+        closing = true;
+        ++i;
+    }
+    const int nameStart = i;
+    while (i < m_length && isNameCharacter(m_text[i].unicode())) {
+        ++i;
+    }
+    const int nameLength = i - nameStart;
+    bool selfClosing = false;
+    bool hasLanguage = false;
+    int languageStart = 0;
+    int languageEnd = 0;
+
+    while (i < m_length && m_text[i].unicode() != '>') {
+        ushort c = m_text[i].unicode();
+        if (!isNameCharacter(c)) {
+            selfClosing = c == '/';
+            if (c == '"' || c == '\'') {
+                //stray quoted text
+                ++i;
+                while (i < m_length && m_text[i].unicode() != c) {
+                    ++i;
+                }
+                //unterminated quote leaves the tag unfinished
+                if (i < m_length) {
+                    ++i;
+                }
+            }
+            else {
+                ++i;
+            }
+            continue;
+        }
+        selfClosing = false;
+        const int attributeStart = i;
+        while (i < m_length && isNameCharacter(m_text[i].unicode())) {
+            ++i;
+        }
+        const int attributeLength = i - attributeStart;
+        while (i < m_length && isSpace(m_text[i].unicode())) {
+            ++i;
+        }
+        if (i == m_length || m_text[i].unicode() != '=') {
+            continue;
+        }
+        ++i;
+        while (i < m_length && isSpace(m_text[i].unicode())) {
+            ++i;
+        }
+        int valueStart = i;
+        int valueEnd = i;
+        if (i < m_length && (m_text[i].unicode() == '"' || m_text[i].unicode() == '\'')) {
+            ushort quote = m_text[i].unicode();
+            valueStart = ++i;
+            while (i < m_length && m_text[i].unicode() != quote) {
+                ++i;
+            }
+            valueEnd = i;
+            if (i < m_length) {
+                ++i;
+            }
+        }
+        else {
+            while (i < m_length && !isSpace(m_text[i].unicode()) && m_text[i].unicode() != '>') {
+                ++i;
+            }
+            valueEnd = i;
+        }
+        if (equalsIgnoreCase(m_text + attributeStart, attributeLength, "lang") ||
+            equalsIgnoreCase(m_text + attributeStart, attributeLength, "xml:lang"))
+        {
+            hasLanguage = true;
+            languageStart = valueStart;
+            languageEnd = valueEnd;
+        }
+    }
+    if (i == m_length) {
+        //tag continues past the end of the text
+        m_position = m_length;
+        m_insideTag = true;
+        return;
+    }
+    m_position = i + 1;
+    if (nameLength == 0) {
+        return;
+    }
+
+    if (closing) {
+        if (!m_scopes.isEmpty() && isScopeName(m_scopes.last(), nameStart, nameLength)) {
+            if (m_scopes.last().nested > 0) {
+                --m_scopes.last().nested;
+            }
+            else {
+                m_scopes.pop_back();
+            }
+        }
+    }
+    else if (!selfClosing && !isVoidElement(m_text + nameStart, nameLength)) {
+        if (hasLanguage) {
+            LanguageScope scope;
+            scope.nameStart = nameStart;
+            scope.nameLength = nameLength;
+            scope.nested = 0;
+            //only copy of the tokenizer, tags with language are rare
+            scope.language = QString(m_text + languageStart, languageEnd - languageStart);
+            m_scopes.push_back(scope);
+        }
+        else if (!m_scopes.isEmpty() && isScopeName(m_scopes.last(), nameStart, nameLength)) {
+            ++m_scopes.last().nested;
+        }
+    }
+}
+
+bool WordTokenizer::isScopeName(const LanguageScope &scope, int nameStart, int nameLength) const
+{
+    if (scope.nameLength != nameLength) {
+        return false;
+    }
+    for (int i = 0; i < nameLength; ++i) {
+        ushort a = m_text[scope.nameStart + i].unicode();
+        ushort b = m_text[nameStart + i].unicode();
+        if (a != b && (a | 0x20) != (b | 0x20)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,95 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_WORD_TOKENIZER_H
+#define BLACK_MILORD_WORD_TOKENIZER_H
+
+#include <QString>
+#include <QChar>
+#include <QVector>
+
+/**
+ * Splits HTML text into words for spell checking.
+ * Markup (including quoted attribute values) and character entities are skipped,
+ * so only words of the text content are returned.
+ * Tokenizer does not copy the text, it returns spans of it. Only values of
+ * lang attributes are copied.
+ * Text passed to the tokenizer has to outlive it and must not be modified.
+ * Language of the returned words is tracked from lang and xml:lang attributes.
+ */
+class WordTokenizer
+{
+public:
+    explicit WordTokenizer(const QString &text);
+    WordTokenizer(const QChar *text, int length);
+
+    /**
+     * Sets position the next word is searched from.
+     * If position is inside a tag, the rest of the tag is skipped.
+     * Moving backward rescans markup from the beginning of the text.
+     */
+    void setPosition(int position);
+    int position() const;
+
+    /**
+     * Skip web and e-mail addresses (http://..., www...., user@host) as a whole
+     * instead of returning their parts as words. Disabled by default.
+     */
+    void setSkipUrls(bool skip);
+
+    /**
+     * Finds next word.
+     * @param start set to position of the first character of the word.
+     * @param end set to position after the last character of the word.
+     * @return false when there are no more words.
+     */
+    bool nextWord(int &start, int &end);
+
+    /**
+     * Language of the innermost element with lang attribute around
+     * the last returned word, empty when text does not specify it.
+     */
+    QString language() const;
+
+private:
+    struct LanguageScope {
+        int nameStart;
+        int nameLength;
+        int nested;
+        QString language;
+    };
+
+    const QChar *m_text;
+    int m_length;
+    int m_position;
+    bool m_insideTag;
+    ushort m_quote;
+    bool m_skipUrls;
+    QVector<LanguageScope> m_scopes;
+
+    int wordCharacterLength(int position) const;
+    void skipEntity();
+    int urlEnd(int position) const;
+    void skipTag();
+    bool isScopeName(const LanguageScope &scope, int nameStart, int nameLength) const;
+};
+
+#endif /* BLACK_MILORD_WORD_TOKENIZER_H */
@@ -10,8 +10,10 @@ SOURCES += Preferences.cpp
 SOURCES += DeviceConfiguration.cpp
 SOURCES += Dictionary.cpp
 SOURCES += Spellcheck.cpp
+SOURCES += WordTokenizer.cpp
 
 HEADERS += Preferences.h
 HEADERS += DeviceConfiguration.h
 HEADERS += Dictionary.h
 HEADERS += Spellcheck.h
+HEADERS += WordTokenizer.h
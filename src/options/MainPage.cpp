@@ -31,6 +31,7 @@
 
 #include <Spellcheck.h>
 #include <Preferences.h>
+#include <HighlighterManager.h>
 
 MainPage::MainPage(QWidget *parent) :
     QWidget(parent),
@@ -49,6 +50,14 @@ MainPage::MainPage(QWidget *parent) :
         selectLanguageFromPreference();
         optionsLayout->addWidget(new QLabel(tr("Spelling check language")), 1, 0);
         optionsLayout->addWidget(m_language, 1, 1);
+
+        optionsLayout->addWidget(new QLabel(tr("Do not check")), 2, 0);
+        addSkipPolicy(optionsLayout, Spellcheck::SKIP_NUMBERS, tr("Numbers"));
+        addSkipPolicy(optionsLayout, Spellcheck::SKIP_WORDS_WITH_DIGITS, tr("Words containing digits"));
+        addSkipPolicy(optionsLayout, Spellcheck::SKIP_ROMAN_NUMERALS, tr("Roman numerals"));
+        addSkipPolicy(optionsLayout, Spellcheck::SKIP_ALL_CAPS, tr("Words in capital letters"));
+        addSkipPolicy(optionsLayout, Spellcheck::SKIP_URLS, tr("Web and e-mail addresses"));
+        addSkipPolicy(optionsLayout, Spellcheck::SKIP_SYMBOLS, tr("Punctuation and symbols"));
     }
 
     optionsLayout->setColumnMinimumWidth(0, 75);
@@ -81,9 +90,27 @@ void MainPage::apply()
     if (Spellcheck::instance().isLoaded()) {
         Spellcheck::instance().changeLanguage(
                 m_language->itemData(m_language->currentIndex(), Qt::UserRole).toString());
+        int policy = 0;
+        for (QMap<int, QCheckBox*>::const_iterator it = m_skipPolicy.begin(); it != m_skipPolicy.end(); ++it) {
+            if (it.value()->isChecked()) {
+                policy |= it.key();
+            }
+        }
+        if (policy != Spellcheck::instance().skipPolicy()) {
+            Spellcheck::instance().setSkipPolicy(policy);
+            HighlighterManager::instance().rehighlight();
+        }
     }
 }
 
+void MainPage::addSkipPolicy(QGridLayout *layout, int policy, const QString &label)
+{
+    QCheckBox *checkBox = new QCheckBox(label);
+    checkBox->setChecked(Spellcheck::instance().skipPolicy() & policy);
+    layout->addWidget(checkBox, 2 + m_skipPolicy.size(), 1);
+    m_skipPolicy.insert(policy, checkBox);
+}
+
 void MainPage::loadLanguages()
 {
     Q_ASSERT(NULL != m_language);
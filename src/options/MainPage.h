@@ -23,12 +23,14 @@
 #define BLACK_MILORD_MAIN_PAGE_H
 
 #include <QWidget>
+#include <QMap>
 #include "IPageWidget.h"
 
 class QListWidget;
 class QStackedWidget;
 class QCheckBox;
 class QComboBox;
+class QGridLayout;
 
 class MainPage : public QWidget, public IPageWidget
 {
@@ -42,9 +44,11 @@ public:
 private:
     QCheckBox *m_makeBackupOverwrite;
     QComboBox *m_language;
+    QMap<int, QCheckBox*> m_skipPolicy;
 
     void loadLanguages();
     void selectLanguageFromPreference();
+    void addSkipPolicy(QGridLayout *layout, int policy, const QString &label);
     void showEvent(QShowEvent *event);
 };
 
@@ -22,7 +22,6 @@
 #include "HighlighterHTMLTags.h"
 #include <QDebug>
 #include <QString>
-#include <QRegExp>
 #include <QBrush>
 #include <QColor>
 #include <QGridLayout>
@@ -45,6 +44,90 @@ namespace {
     const QString PROP_NORMAL_BACKGROUND_ENABLED = "normal_background_color_enabled";
     const QString PROP_INVALID_FOREGROUND_ENABLED = "invalid_foreground_color_enabled";
     const QString PROP_INVALID_BACKGROUND_ENABLED = "invalid_background_color_enabled";
+
+    bool isAsciiLetter(QChar c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    int skipSpaces(const QString &text, int position, int end)
+    {
+        while (position < end && text[position].isSpace()) {
+            ++position;
+        }
+        return position;
+    }
+
+    //matches \s*([A-Za-z]+\s*=\s*"[ A-Za-z0-9]*"\s*)*\/?\s* exactly between position and end
+    bool matchesAttributes(const QString &text, int position, int end)
+    {
+        position = skipSpaces(text, position, end);
+        while (position < end && isAsciiLetter(text[position])) {
+            while (position < end && isAsciiLetter(text[position])) {
+                ++position;
+            }
+            position = skipSpaces(text, position, end);
+            if (position == end || text[position] != '=') {
+                return false;
+            }
+            position = skipSpaces(text, position + 1, end);
+            if (position == end || text[position] != '"') {
+                return false;
+            }
+            ++position;
+            while (position < end && (text[position] == ' ' || isAsciiLetter(text[position]) ||
+                (text[position] >= '0' && text[position] <= '9')))
+            {
+                ++position;
+            }
+            if (position == end || text[position] != '"') {
+                return false;
+            }
+            position = skipSpaces(text, position + 1, end);
+        }
+        if (position < end && text[position] == '/') {
+            position = skipSpaces(text, position + 1, end);
+        }
+        return position == end;
+    }
+
+    /**
+     * Finds a tag starting at or after from, a tag ends at the first '>' after its '<'.
+     * Tag name runs up to the first space or '/', the rest of the tag must be valid attributes.
+     * Every part of the text is scanned once.
+     * @return position of the '<' or -1.
+     */
+    int findTag(const QString &text, int from, int &length, QString &name)
+    {
+        int close = text.indexOf('>', from);
+        int open = text.indexOf('<', from);
+        while (open != -1 && close != -1) {
+            if (close < open) {
+                close = text.indexOf('>', open);
+                if (close == -1) {
+                    break;
+                }
+            }
+            int nameStart = skipSpaces(text, open + 1, close);
+            if (nameStart < close && text[nameStart] == '/') {
+                nameStart = skipSpaces(text, nameStart + 1, close);
+            }
+            int nameEnd = nameStart;
+            while (nameEnd < close && !text[nameEnd].isSpace() && text[nameEnd] != '/') {
+                ++nameEnd;
+            }
+            //attributes stop at the first '<', so a failed tag is not rescanned by the next one
+            if (matchesAttributes(text, nameEnd, close)) {
+                length = close + 1 - open;
+                name = text.mid(nameStart, nameEnd - nameStart);
+                return open;
+            }
+            //tag started by '<' inside the name, but not at its end, has the same attributes,
+            //so it is not valid either
+            open = text.indexOf('<', qMax(open + 1, nameEnd - 1));
+        }
+        return -1;
+    }
 }
 
 Q_EXPORT_PLUGIN2(highlighter_html, HighlighterHTMLTags)
@@ -76,21 +159,19 @@ PluginHighlighter::FormatListPtr HighlighterHTMLTags::highlightBlock(const QStri
         htmlInvalidFormat.setBackground(QBrush(m_backgroundInvalid));
     }
 
-    QRegExp rx("<\\s*/?\\s*([^\\s>/]*)\\s*([A-Za-z]+\\s*=\\s*\"[ A-Za-z0-9]*\"\\s*)*/?\\s*>");
-    rx.setMinimal(true);
-
     const QStringList &validTags = DeviceConfiguration::instance().getValidHTMLTags();
-    int index = text.indexOf(rx);
+    int length = 0;
+    QString name;
+    int index = findTag(text, 0, length, name);
     while (index >= 0) {
-        int length = rx.matchedLength();
-        if (validTags.contains(rx.capturedTexts().at(1), Qt::CaseInsensitive)) {
+        if (validTags.contains(name, Qt::CaseInsensitive)) {
             result->push_back(PluginHighlighter::CharFormat(index, index + length, htmlFormat));
         }
         else {
-            qDebug() << rx.capturedTexts().at(1);
+            qDebug() << name;
             result->push_back(PluginHighlighter::CharFormat(index, index + length, htmlInvalidFormat));
         }
-        index = text.indexOf(rx, index + length);
+        index = findTag(text, index + length, length, name);
     }
     return result;
 }
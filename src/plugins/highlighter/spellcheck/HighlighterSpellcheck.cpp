@@ -27,6 +27,7 @@
 #include <QtPlugin>
 
 #include <Spellcheck.h>
+#include <WordTokenizer.h>
 #include <Preferences.h>
 
 namespace {
@@ -54,54 +55,17 @@ PluginHighlighter::FormatListPtr HighlighterSpellcheck::highlightBlock(const QSt
     errorFormat.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
     errorFormat.setUnderlineColor(QColor(255, 0, 0));
 
-    QTextBoundaryFinder finder(QTextBoundaryFinder::Word, text);
+    WordTokenizer tokenizer(text);
+    tokenizer.setSkipUrls(Spellcheck::instance().skipPolicy() & Spellcheck::SKIP_URLS);
     int startPos = 0;
     int endPos = 0;
-    bool insideTag = false;
-    finder.toStart();
-
-    while (!finder.boundaryReasons().testFlag(QTextBoundaryFinder::StartWord)) {
-        startPos = finder.toNextBoundary();
-        if (startPos == -1) {
-            return result;
-        }
-    }
-    if (!finder.boundaryReasons().testFlag(QTextBoundaryFinder::StartWord)) {
-        return result;
-    }
-
-    endPos = finder.toNextBoundary();
-    if (endPos == -1) {
-        return result;
-    }
-
-    while (true) {
-        QString word = text.mid(startPos, endPos - startPos);
-        if (word == "<") {
-            insideTag = true;
-        }
-        else if (word == ">") {
-            insideTag = false;
-        }
-        if (!insideTag) {
-            /* if (word == " ") {
-                //double spaces
-                result.push_back(AbstractHighlighter::CharFormat(startPos, endPos, errorFormat));
-            } else */
-            if (!Spellcheck::instance().checkWord(word)) {
-                result->push_back(PluginHighlighter::CharFormat(startPos, endPos, errorFormat));
-            }
-        }
-        if (finder.boundaryReasons() & QTextBoundaryFinder::StartWord) {
-            startPos = endPos;
-            endPos = finder.toNextBoundary();
-        }
-        else {
-            startPos = finder.toNextBoundary();
-            endPos = finder.toNextBoundary();
-        }
-        if (startPos == -1 || endPos == -1) {
-            break;
+    while (tokenizer.nextWord(startPos, endPos)) {
+        //word is not copied, it refers to the block text
+        if (!Spellcheck::instance().checkWord(
+                QString::fromRawData(text.constData() + startPos, endPos - startPos),
+                tokenizer.language()))
+        {
+            result->push_back(PluginHighlighter::CharFormat(startPos, endPos, errorFormat));
         }
     }
     return result;
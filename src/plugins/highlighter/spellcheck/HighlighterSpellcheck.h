@@ -22,7 +22,7 @@
 #ifndef BLACK_MILORD_HIGHLIGHTER_SPELLING_ERROR_H
 #define BLACK_MILORD_HIGHLIGHTER_SPELLING_ERROR_H
 
-#include <QTextBoundaryFinder>
+#include <QObject>
 
 #include <PluginHighlighter.h>
 
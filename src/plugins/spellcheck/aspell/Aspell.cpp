@@ -44,71 +44,109 @@ ASpell::ASpell() :
         return;
     }
     changeLanguage(Preferences::instance().getAspellDictionary());
-    qDebug() << "Aspell is loaded";
+    if (!m_spellChecker) {
+        //dictionary from preferences is missing, try the default one of Aspell
+        const char *defaultLanguage = aspell_config_retrieve(m_spellConfig, "lang");
+        if (defaultLanguage) {
+            changeLanguage(QString::fromUtf8(defaultLanguage));
+        }
+    }
+    qDebug() << "Aspell is loaded" << isLoaded();
 }
 
 ASpell::~ASpell()
 {
-    if (m_spellChecker) {
-        delete_aspell_speller(m_spellChecker);
+    foreach (AspellSpeller *speller, m_spellers) {
+        delete_aspell_speller(speller);
     }
     if (m_spellConfig) {
         delete_aspell_config(m_spellConfig);
     }
 }
 
-void ASpell::changeLanguage(const QString &code)
+AspellSpeller* ASpell::speller(const QString &code) const
 {
-    QMutexLocker lock(&m_mutex);
-    if (code == m_language) {
-        return;
+    QHash<QString, AspellSpeller*>::const_iterator it = m_spellers.find(code);
+    if (it != m_spellers.end()) {
+        return it.value();
     }
-    if (m_spellChecker) {
-        delete_aspell_speller(m_spellChecker);
-        m_spellChecker = NULL;
+    if (!m_spellConfig || code.isEmpty() || m_failedLanguages.contains(code)) {
+        return NULL;
     }
-    if (!aspell_config_replace(m_spellConfig, "lang", code.toUtf8().constData()))
+    AspellConfig *config = aspell_config_clone(m_spellConfig);
+    if (!aspell_config_replace(config, "lang", code.toUtf8().constData()))
     {
         qDebug() << "Cannot set language";
-        return;
+        delete_aspell_config(config);
+        m_failedLanguages.insert(code);
+        return NULL;
     }
-    if (!aspell_config_replace(m_spellConfig, "encoding", "utf-8"))
+    if (!aspell_config_replace(config, "encoding", "utf-8"))
     {
         qDebug() << "Cannot set encoding";
-        return;
+        delete_aspell_config(config);
+        m_failedLanguages.insert(code);
+        return NULL;
     }
 
-    AspellCanHaveError *possibleErr = new_aspell_speller(m_spellConfig);
+    AspellCanHaveError *possibleErr = new_aspell_speller(config);
+    delete_aspell_config(config);
     if (aspell_error_number(possibleErr) != 0) {
         qDebug() << aspell_error_message(possibleErr);
-        m_language.clear();
+        delete_aspell_can_have_error(possibleErr);
+        m_failedLanguages.insert(code);
+        return NULL;
+    }
+    AspellSpeller *result = to_aspell_speller(possibleErr);
+    m_spellers.insert(code, result);
+    return result;
+}
+
+void ASpell::changeLanguage(const QString &code)
+{
+    QMutexLocker lock(&m_mutex);
+    if (code == m_language) {
+        return;
     }
-    else {
-        m_spellChecker = to_aspell_speller(possibleErr);
-        m_language = code;
-        Preferences::instance().setAspellDictionary(m_language);
+    AspellSpeller *newSpeller = speller(code);
+    if (!newSpeller) {
+        return;
     }
+    m_spellChecker = newSpeller;
+    m_language = code;
+    Preferences::instance().setAspellDictionary(m_language);
 }
 
 bool ASpell::isLoaded() const
 {
     QMutexLocker lock(&m_mutex);
-    return m_spellConfig != NULL;
+    //without a dictionary every word would be accepted
+    return m_spellChecker != NULL;
 }
 
-bool ASpell::checkWord(const QString &word) const
+bool ASpell::checkWord(const QString &word, const QString &language) const
 {
     QMutexLocker lock(&m_mutex);
     if (!isLoaded()) {
         return true;
     }
-    return 1 ==  aspell_speller_check(m_spellChecker, word.toUtf8().constData(), -1);
+    AspellSpeller *checker = language.isEmpty() ? m_spellChecker : speller(language);
+    if (!checker) {
+        checker = m_spellChecker;
+    }
+    if (!checker) {
+        return true;
+    }
+    return 1 ==  aspell_speller_check(checker, word.toUtf8().constData(), -1);
 }
 
 bool ASpell::addWordToSessionDictionary(const QString &word)
 {
     qDebug() << "Adding word to session dictionary" << word;
     QMutexLocker lock(&m_mutex);
+    if (!m_spellChecker) {
+        return false;
+    }
     return 0 != aspell_speller_add_to_session(m_spellChecker, word.toUtf8().constData(), -1);
 }
 
@@ -116,17 +154,27 @@ bool ASpell::addWordToPersonalDictionary(const QString &word)
 {
     qDebug() << "Adding word to personal dictionary" << word;
     QMutexLocker lock(&m_mutex);
+    if (!m_spellChecker) {
+        return false;
+    }
     if (0 != aspell_speller_add_to_personal(m_spellChecker, word.toUtf8().constData(), -1)) {
         return 0 != aspell_speller_save_all_word_lists(m_spellChecker);
     }
     return false;
 }
 
-QStringList ASpell::hints(const QString &word) const
+QStringList ASpell::hints(const QString &word, const QString &language) const
 {
     QStringList result;
     QMutexLocker lock(&m_mutex);
-    const AspellWordList *suggestions = aspell_speller_suggest(m_spellChecker, word.toUtf8().constData(), -1);
+    AspellSpeller *checker = language.isEmpty() ? m_spellChecker : speller(language);
+    if (!checker) {
+        checker = m_spellChecker;
+    }
+    if (!checker) {
+        return result;
+    }
+    const AspellWordList *suggestions = aspell_speller_suggest(checker, word.toUtf8().constData(), -1);
     AspellStringEnumeration *elements = aspell_word_list_elements(suggestions);
     const char *hint;
     while ((hint = aspell_string_enumeration_next(elements)) != NULL) {
@@ -146,7 +194,7 @@ QList<QPair<QString, QString> > ASpell::availableLanguages() const
 {
     QList<QPair<QString, QString> > result;
     QMutexLocker lock(&m_mutex);
-    if (!isLoaded()) {
+    if (!m_spellConfig) {
         qDebug() << "Cannot obtain dictionary list";
         return result;
     }
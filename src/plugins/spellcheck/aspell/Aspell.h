@@ -29,6 +29,8 @@
 #include <aspell.h>
 
 #include <QMutex>
+#include <QHash>
+#include <QSet>
 #include <PluginSpellcheck.h>
 
 class ASpell :
@@ -42,10 +44,10 @@ public:
     ASpell();
     ~ASpell();
     bool isLoaded() const;
-    bool checkWord(const QString &word) const;
+    bool checkWord(const QString &word, const QString &language) const;
     bool addWordToSessionDictionary(const QString &word);
     bool addWordToPersonalDictionary(const QString &word);
-    QStringList hints(const QString &word) const;
+    QStringList hints(const QString &word, const QString &language) const;
     QString language() const;
     QList<QPair<QString, QString> > availableLanguages() const;
     void changeLanguage(const QString &code);
@@ -58,10 +60,15 @@ public:
     QString name() const;
 
 private:
+    AspellSpeller* speller(const QString &code) const;
+
     mutable QMutex m_mutex;
     AspellConfig* m_spellConfig;
     AspellSpeller* m_spellChecker;
     QString m_language;
+    //spellers are kept warm, creating one takes seconds for large dictionaries
+    mutable QHash<QString, AspellSpeller*> m_spellers;
+    mutable QSet<QString> m_failedLanguages;
 
 #if (defined Q_WS_X11 || defined Q_WS_MAC)
     void *m_handle;
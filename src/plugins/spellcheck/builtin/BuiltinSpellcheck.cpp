@@ -0,0 +1,429 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "BuiltinSpellcheck.h"
+#include "CompiledDictionary.h"
+#include <QDebug>
+#include <QtPlugin>
+#include <cstring>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QMutexLocker>
+#include <QApplication>
+#include <Preferences.h>
+#include <Dictionary.h>
+
+Q_EXPORT_PLUGIN2(spellcheck_builtin, BuiltinSpellcheck)
+
+namespace {
+    const int MAX_WORD_LENGTH = 64;
+    const int MAX_HINTS = 10;
+    // keeps the distance 2 search in the range of milliseconds
+    const int MAX_HINT_ALPHABET = 40;
+
+    template <typename Visitor>
+    void forEachEdit(const QChar *word, int length, const QChar *alphabet, int alphabetLength, Visitor &visitor)
+    {
+        QChar buffer[MAX_WORD_LENGTH + 2];
+        for (int i = 0; i < length; ++i) {
+            memcpy(buffer, word, i * sizeof(QChar));
+            memcpy(buffer + i, word + i + 1, (length - i - 1) * sizeof(QChar));
+            visitor(buffer, length - 1);
+        }
+        memcpy(buffer, word, length * sizeof(QChar));
+        for (int i = 0; i + 1 < length; ++i) {
+            if (word[i] != word[i + 1]) {
+                qSwap(buffer[i], buffer[i + 1]);
+                visitor(buffer, length);
+                qSwap(buffer[i], buffer[i + 1]);
+            }
+        }
+        for (int i = 0; i < length; ++i) {
+            for (int a = 0; a < alphabetLength; ++a) {
+                if (alphabet[a] != word[i]) {
+                    buffer[i] = alphabet[a];
+                    visitor(buffer, length);
+                }
+            }
+            buffer[i] = word[i];
+        }
+        for (int i = 0; i <= length; ++i) {
+            memcpy(buffer, word, i * sizeof(QChar));
+            memcpy(buffer + i + 1, word + i, (length - i) * sizeof(QChar));
+            for (int a = 0; a < alphabetLength; ++a) {
+                buffer[i] = alphabet[a];
+                visitor(buffer, length + 1);
+            }
+        }
+    }
+
+    template <typename Visitor>
+    struct SecondEdit
+    {
+        SecondEdit(const QChar *alphabet, int alphabetLength, Visitor &visitor) :
+            m_alphabet(alphabet), m_alphabetLength(alphabetLength), m_visitor(visitor) {}
+        void operator()(const QChar *word, int length)
+        {
+            forEachEdit(word, length, m_alphabet, m_alphabetLength, m_visitor);
+        }
+        const QChar *m_alphabet;
+        int m_alphabetLength;
+        Visitor &m_visitor;
+    };
+}
+
+struct BuiltinSpellcheck::HintCollector
+{
+    HintCollector(const BuiltinSpellcheck *owner, const Language *language) :
+        m_owner(owner), m_language(language) {}
+    void operator()(const QChar *word, int length)
+    {
+        if (m_result.size() < MAX_HINTS && length > 0 && m_owner->isKnown(m_language, word, length)) {
+            QString hint(word, length);
+            if (!m_seen.contains(hint)) {
+                m_seen.insert(hint);
+                m_result.push_back(hint);
+            }
+        }
+    }
+    const BuiltinSpellcheck *m_owner;
+    const Language *m_language;
+    QStringList m_result;
+    QSet<QString> m_seen;
+};
+
+BuiltinSpellcheck::BuiltinSpellcheck() :
+    m_current(NULL)
+{
+    changeLanguage(Preferences::instance().getAspellDictionary());
+    if (!isLoaded()) {
+        QList<QPair<QString, QString> > languages = availableLanguages();
+        if (!languages.isEmpty()) {
+            changeLanguage(languages.first().second);
+        }
+    }
+    if (isLoaded()) {
+        qDebug() << "Built-in spellcheck is loaded";
+    }
+}
+
+BuiltinSpellcheck::~BuiltinSpellcheck()
+{
+    foreach (Language *language, m_languages) {
+        delete language->dictionary;
+        delete language;
+    }
+}
+
+QStringList BuiltinSpellcheck::dictionaryDirectories() const
+{
+    QStringList result;
+    result.push_back(QDir(Preferences::instance().getConfigDirectory()).absoluteFilePath("dictionaries"));
+    result.push_back(QDir(qApp->applicationDirPath()).absoluteFilePath("dictionaries"));
+#if (defined Q_WS_X11 || defined Q_WS_MAC)
+    result.push_back("/usr/share/hunspell");
+    result.push_back("/usr/share/myspell/dicts");
+#endif
+    return result;
+}
+
+QString BuiltinSpellcheck::dictionaryFile(const QString &code) const
+{
+    foreach (const QString &directory, dictionaryDirectories()) {
+        QDir dir(directory);
+        if (dir.exists(code + ".dic")) {
+            return dir.absoluteFilePath(code + ".dic");
+        }
+        if (dir.exists(code + ".txt")) {
+            return dir.absoluteFilePath(code + ".txt");
+        }
+    }
+    return QString();
+}
+
+QString BuiltinSpellcheck::cacheFile(const QString &code) const
+{
+    return QDir(Preferences::instance().getConfigDirectory()).absoluteFilePath("cache/" + code + ".bmd");
+}
+
+QString BuiltinSpellcheck::personalFile(const QString &code) const
+{
+    return QDir(Preferences::instance().getConfigDirectory()).absoluteFilePath("personal/" + code + ".txt");
+}
+
+const BuiltinSpellcheck::Language* BuiltinSpellcheck::findLanguage(const QString &code) const
+{
+    QHash<QString, Language*>::const_iterator it = m_languages.find(code);
+    return it != m_languages.end() ? it.value() : NULL;
+}
+
+const BuiltinSpellcheck::Language* BuiltinSpellcheck::acquireLanguage(const QString &code) const
+{
+    {
+        QReadLocker lock(&m_lock);
+        const Language *language = findLanguage(code);
+        if (language) {
+            return language;
+        }
+        if (code.isEmpty() || m_failedLanguages.contains(code)) {
+            return m_current;
+        }
+    }
+    loadLanguage(code);
+    QReadLocker lock(&m_lock);
+    const Language *language = findLanguage(code);
+    return language ? language : m_current;
+}
+
+bool BuiltinSpellcheck::loadLanguage(const QString &code) const
+{
+    //one compilation at a time, both threads may ask for the same language
+    QMutexLocker loadLock(&m_loadMutex);
+    {
+        QReadLocker lock(&m_lock);
+        if (findLanguage(code)) {
+            return true;
+        }
+        if (m_failedLanguages.contains(code)) {
+            return false;
+        }
+    }
+    QString source = dictionaryFile(code);
+    CompiledDictionary *dictionary = new CompiledDictionary;
+    if (source.isEmpty() || !dictionary->load(source, cacheFile(code))) {
+        qDebug() << "Cannot load dictionary for" << code;
+        delete dictionary;
+        QWriteLocker lock(&m_lock);
+        m_failedLanguages.insert(code);
+        return false;
+    }
+    Language *language = new Language;
+    language->dictionary = dictionary;
+    QFile personal(personalFile(code));
+    if (personal.open(QIODevice::ReadOnly)) {
+        foreach (const QString &word, QString::fromUtf8(personal.readAll()).split('\n', QString::SkipEmptyParts)) {
+            language->personalWords.insert(word.trimmed());
+        }
+    }
+    QWriteLocker lock(&m_lock);
+    m_languages.insert(code, language);
+    return true;
+}
+
+void BuiltinSpellcheck::changeLanguage(const QString &code)
+{
+    if (code.isEmpty() || code == language()) {
+        return;
+    }
+    if (!loadLanguage(code)) {
+        return;
+    }
+    QWriteLocker lock(&m_lock);
+    m_current = m_languages.value(code);
+    m_language = code;
+    Preferences::instance().setAspellDictionary(m_language);
+}
+
+bool BuiltinSpellcheck::isLoaded() const
+{
+    QReadLocker lock(&m_lock);
+    return m_current != NULL;
+}
+
+bool BuiltinSpellcheck::isKnown(const Language *language, const QChar *word, int length) const
+{
+    if (language->dictionary->contains(word, length)) {
+        return true;
+    }
+    if (m_sessionWords.isEmpty() && language->personalWords.isEmpty()) {
+        return false;
+    }
+    QString view = QString::fromRawData(word, length);
+    return m_sessionWords.contains(view) || language->personalWords.contains(view);
+}
+
+bool BuiltinSpellcheck::checkWord(const QString &word, const QString &code) const
+{
+    const Language *language = acquireLanguage(code);
+    QReadLocker lock(&m_lock);
+    if (!language) {
+        return true;
+    }
+    const int length = word.length();
+    if (isKnown(language, word.constData(), length)) {
+        return true;
+    }
+    if (0 == length || length > MAX_WORD_LENGTH || !word[0].isUpper()) {
+        return false;
+    }
+    // "Word" at the beginning of a sentence and "WORD" in headings
+    QChar buffer[MAX_WORD_LENGTH];
+    bool allUpper = true;
+    buffer[0] = word[0].toLower();
+    for (int i = 1; i < length; ++i) {
+        buffer[i] = word[i];
+        allUpper = allUpper && !word[i].isLower();
+    }
+    if (isKnown(language, buffer, length)) {
+        return true;
+    }
+    if (!allUpper || length == 1) {
+        return false;
+    }
+    for (int i = 1; i < length; ++i) {
+        buffer[i] = word[i].toLower();
+    }
+    if (isKnown(language, buffer, length)) {
+        return true;
+    }
+    buffer[0] = word[0];
+    return isKnown(language, buffer, length);
+}
+
+bool BuiltinSpellcheck::addWordToSessionDictionary(const QString &word)
+{
+    qDebug() << "Adding word to session dictionary" << word;
+    QWriteLocker lock(&m_lock);
+    m_sessionWords.insert(word);
+    return true;
+}
+
+bool BuiltinSpellcheck::addWordToPersonalDictionary(const QString &word)
+{
+    qDebug() << "Adding word to personal dictionary" << word;
+    QWriteLocker lock(&m_lock);
+    if (!m_current) {
+        return false;
+    }
+    QString fileName = personalFile(m_language);
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "Cannot write personal dictionary" << fileName << file.errorString();
+        return false;
+    }
+    if (-1 == file.write(word.toUtf8() + '\n')) {
+        return false;
+    }
+    m_current->personalWords.insert(word);
+    return true;
+}
+
+QStringList BuiltinSpellcheck::hints(const QString &word, const QString &code) const
+{
+    const Language *language = acquireLanguage(code);
+    QReadLocker lock(&m_lock);
+    if (!language || word.isEmpty() || word.length() > MAX_WORD_LENGTH) {
+        return QStringList();
+    }
+    const CompiledDictionary *dictionary = language->dictionary;
+    const QString lower = word.toLower();
+    const bool capitalized = word[0].isUpper();
+    const bool allUpper = capitalized && word.length() > 1 && word == word.toUpper();
+    const int alphabetLength = qMin(dictionary->alphabetLength(), MAX_HINT_ALPHABET);
+
+    HintCollector collector(this, language);
+    forEachEdit(lower.constData(), lower.length(), dictionary->alphabet(), alphabetLength, collector);
+    if (collector.m_result.size() < MAX_HINTS) {
+        SecondEdit<HintCollector> secondEdit(dictionary->alphabet(), alphabetLength, collector);
+        forEachEdit(lower.constData(), lower.length(), dictionary->alphabet(), alphabetLength, secondEdit);
+    }
+
+    QStringList result;
+    foreach (QString hint, collector.m_result) {
+        if (allUpper) {
+            hint = hint.toUpper();
+        }
+        else if (capitalized) {
+            hint[0] = hint[0].toUpper();
+        }
+        if (!result.contains(hint)) {
+            result.push_back(hint);
+        }
+    }
+    return result;
+}
+
+QString BuiltinSpellcheck::language() const
+{
+    QReadLocker lock(&m_lock);
+    return m_language;
+}
+
+QList<QPair<QString, QString> > BuiltinSpellcheck::availableLanguages() const
+{
+    QList<QPair<QString, QString> > result;
+    QStringList codes;
+    QStringList filters;
+    filters << "*.dic" << "*.txt";
+    foreach (const QString &directory, dictionaryDirectories()) {
+        foreach (const QFileInfo &file, QDir(directory).entryInfoList(filters, QDir::Files | QDir::Readable)) {
+            QString code = file.completeBaseName();
+            if (codes.contains(code)) {
+                continue;
+            }
+            codes.push_back(code);
+            QString readable;
+            QStringList splitted = code.split("_");
+            if (splitted.size() > 1) {
+                readable = Dictionary::languageCode(splitted[0]) + " (" + splitted[1] + ")";
+            }
+            else {
+                readable = Dictionary::languageCode(code);
+            }
+            result.push_back(qMakePair<QString, QString>(readable, code));
+        }
+    }
+    return result;
+}
+
+QLayout* BuiltinSpellcheck::configurationLayout()
+{
+    return NULL;
+}
+
+void BuiltinSpellcheck::resetConfigurationLayout()
+{
+
+}
+
+void BuiltinSpellcheck::saveSettings()
+{
+
+}
+
+void BuiltinSpellcheck::applySettings()
+{
+
+}
+
+QString BuiltinSpellcheck::guid() const
+{
+    return "6A3F0C1E-2B7D-4F58-9E41-0D8C5B7A2E93";
+}
+
+QString BuiltinSpellcheck::name() const
+{
+    return tr("Built-in dictionary");
+}
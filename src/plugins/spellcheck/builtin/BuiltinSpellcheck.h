@@ -0,0 +1,88 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_BUILTIN_SPELLCHECK_H
+#define BLACK_MILORD_BUILTIN_SPELLCHECK_H
+
+#include <QObject>
+#include <QReadWriteLock>
+#include <QMutex>
+#include <QSet>
+#include <QHash>
+#include <QStringList>
+#include <PluginSpellcheck.h>
+
+class CompiledDictionary;
+
+class BuiltinSpellcheck :
+    public QObject,
+    public PluginSpellcheck
+{
+    Q_OBJECT
+    Q_INTERFACES(PluginSpellcheck)
+
+public:
+    BuiltinSpellcheck();
+    ~BuiltinSpellcheck();
+    bool isLoaded() const;
+    bool checkWord(const QString &word, const QString &language) const;
+    bool addWordToSessionDictionary(const QString &word);
+    bool addWordToPersonalDictionary(const QString &word);
+    QStringList hints(const QString &word, const QString &language) const;
+    QString language() const;
+    QList<QPair<QString, QString> > availableLanguages() const;
+    void changeLanguage(const QString &code);
+
+    QLayout* configurationLayout();
+    void resetConfigurationLayout();
+    void saveSettings();
+    void applySettings();
+    QString guid() const;
+    QString name() const;
+
+private:
+    struct HintCollector;
+    struct Language {
+        CompiledDictionary *dictionary;
+        QSet<QString> personalWords;
+    };
+
+    const Language* findLanguage(const QString &code) const;
+    const Language* acquireLanguage(const QString &code) const;
+    bool loadLanguage(const QString &code) const;
+    bool isKnown(const Language *language, const QChar *word, int length) const;
+
+    QStringList dictionaryDirectories() const;
+    QString dictionaryFile(const QString &code) const;
+    QString cacheFile(const QString &code) const;
+    QString personalFile(const QString &code) const;
+
+    mutable QReadWriteLock m_lock;
+    mutable QMutex m_loadMutex;
+    //dictionaries are kept loaded, switching between them is free
+    mutable QHash<QString, Language*> m_languages;
+    mutable QSet<QString> m_failedLanguages;
+    Language *m_current;
+    QString m_language;
+    QSet<QString> m_sessionWords;
+};
+
+#endif /* BLACK_MILORD_BUILTIN_SPELLCHECK_H */
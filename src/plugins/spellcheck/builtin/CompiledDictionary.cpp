@@ -0,0 +1,351 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "CompiledDictionary.h"
+#include "WordListReader.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <cstring>
+
+namespace {
+    const quint32 MAGIC = 0x444d4c42; // "BLMD"
+    const quint32 VERSION = 1;
+
+    inline quint32 hashWord(const QChar *word, int length)
+    {
+        // FNV-1a over UTF-16 code units
+        quint32 hash = 2166136261u;
+        for (int i = 0; i < length; ++i) {
+            hash ^= word[i].unicode();
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+}
+
+// cache files are never shared between machines, so native byte order is used
+struct CompiledDictionary::Header
+{
+    quint32 magic;
+    quint32 version;
+    qint64 sourceSize;
+    qint64 sourceModified;
+    quint32 wordCount;
+    quint32 tableSize;
+    quint32 alphabetLength;
+    quint32 poolLength;
+};
+
+struct CompiledDictionary::Slot
+{
+    quint32 hash;
+    quint32 entry; // index + 1, 0 marks an empty slot
+};
+
+struct CompiledDictionary::Entry
+{
+    quint32 offset;
+    quint32 length;
+};
+
+CompiledDictionary::CompiledDictionary() :
+    m_data(NULL),
+    m_header(NULL),
+    m_table(NULL),
+    m_entries(NULL),
+    m_alphabet(NULL),
+    m_pool(NULL)
+{
+}
+
+CompiledDictionary::~CompiledDictionary()
+{
+    close();
+}
+
+bool CompiledDictionary::load(const QString &sourceFileName, const QString &cacheFileName)
+{
+    close();
+    QFileInfo source(sourceFileName);
+    if (!source.exists()) {
+        qDebug() << "Dictionary does not exist" << sourceFileName;
+        return false;
+    }
+    if (open(cacheFileName, source)) {
+        return true;
+    }
+    qDebug() << "Compiling dictionary" << sourceFileName;
+    DictionaryBuilder builder;
+    if (!WordListReader::read(sourceFileName, builder) ||
+        !builder.write(cacheFileName, source))
+    {
+        return false;
+    }
+    return open(cacheFileName, source);
+}
+
+bool CompiledDictionary::open(const QString &cacheFileName, const QFileInfo &source)
+{
+    m_file.setFileName(cacheFileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    qint64 size = m_file.size();
+    if (size < static_cast<qint64>(sizeof(Header))) {
+        close();
+        return false;
+    }
+    m_data = m_file.map(0, size);
+    if (!m_data) {
+        qDebug() << "Cannot map" << cacheFileName << m_file.errorString();
+        close();
+        return false;
+    }
+    m_header = reinterpret_cast<const Header*>(m_data);
+    if (m_header->magic != MAGIC ||
+        m_header->version != VERSION ||
+        m_header->sourceSize != source.size() ||
+        m_header->sourceModified != source.lastModified().toTime_t() ||
+        m_header->tableSize == 0 ||
+        (m_header->tableSize & (m_header->tableSize - 1)) != 0 ||
+        m_header->wordCount >= m_header->tableSize)
+    {
+        close();
+        return false;
+    }
+    qint64 expected = sizeof(Header) +
+            static_cast<qint64>(m_header->tableSize) * sizeof(Slot) +
+            static_cast<qint64>(m_header->wordCount) * sizeof(Entry) +
+            (static_cast<qint64>(m_header->alphabetLength) + m_header->poolLength) * sizeof(QChar);
+    if (expected != size) {
+        close();
+        return false;
+    }
+    const uchar *position = m_data + sizeof(Header);
+    m_table = reinterpret_cast<const Slot*>(position);
+    position += m_header->tableSize * sizeof(Slot);
+    m_entries = reinterpret_cast<const Entry*>(position);
+    position += m_header->wordCount * sizeof(Entry);
+    m_alphabet = reinterpret_cast<const QChar*>(position);
+    position += m_header->alphabetLength * sizeof(QChar);
+    m_pool = reinterpret_cast<const QChar*>(position);
+
+    //every word has one slot, so lookups always reach an empty slot and stop
+    quint32 usedSlots = 0;
+    for (quint32 i = 0; i < m_header->tableSize; ++i) {
+        if (m_table[i].entry > m_header->wordCount) {
+            close();
+            return false;
+        }
+        if (m_table[i].entry) {
+            ++usedSlots;
+        }
+    }
+    if (usedSlots != m_header->wordCount) {
+        close();
+        return false;
+    }
+    for (quint32 i = 0; i < m_header->wordCount; ++i) {
+        if (m_entries[i].offset > m_header->poolLength ||
+            m_entries[i].length > m_header->poolLength - m_entries[i].offset)
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void CompiledDictionary::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+    m_file.close();
+    m_data = NULL;
+    m_header = NULL;
+    m_table = NULL;
+    m_entries = NULL;
+    m_alphabet = NULL;
+    m_pool = NULL;
+}
+
+bool CompiledDictionary::isLoaded() const
+{
+    return m_header != NULL;
+}
+
+bool CompiledDictionary::contains(const QChar *word, int length) const
+{
+    if (!m_header || length <= 0) {
+        return false;
+    }
+    const quint32 hash = hashWord(word, length);
+    const quint32 mask = m_header->tableSize - 1;
+    for (quint32 index = hash & mask; m_table[index].entry; index = (index + 1) & mask) {
+        if (m_table[index].hash != hash) {
+            continue;
+        }
+        const Entry &entry = m_entries[m_table[index].entry - 1];
+        if (entry.length == static_cast<quint32>(length) &&
+            0 == memcmp(m_pool + entry.offset, word, length * sizeof(QChar)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CompiledDictionary::contains(const QString &word) const
+{
+    return contains(word.constData(), word.length());
+}
+
+const QChar* CompiledDictionary::alphabet() const
+{
+    return m_alphabet;
+}
+
+int CompiledDictionary::alphabetLength() const
+{
+    return m_header ? m_header->alphabetLength : 0;
+}
+
+DictionaryBuilder::DictionaryBuilder()
+{
+}
+
+void DictionaryBuilder::addWord(const QString &word)
+{
+    if (word.isEmpty()) {
+        return;
+    }
+    m_offsets.push_back(m_pool.size());
+    m_lengths.push_back(word.length());
+    for (int i = 0; i < word.length(); ++i) {
+        m_pool.push_back(word[i]);
+    }
+}
+
+bool DictionaryBuilder::write(const QString &fileName, const QFileInfo &source) const
+{
+    quint32 tableSize = 16;
+    while (tableSize < 2u * m_offsets.size()) {
+        tableSize <<= 1;
+    }
+    const quint32 mask = tableSize - 1;
+
+    QVector<CompiledDictionary::Slot> table(tableSize);
+    memset(table.data(), 0, tableSize * sizeof(CompiledDictionary::Slot));
+    QVector<CompiledDictionary::Entry> entries;
+    entries.reserve(m_offsets.size());
+    QVector<QChar> pool;
+    pool.reserve(m_pool.size());
+    QHash<ushort, int> frequency;
+
+    for (int i = 0; i < m_offsets.size(); ++i) {
+        const QChar *word = m_pool.constData() + m_offsets[i];
+        const quint32 length = m_lengths[i];
+        const quint32 hash = hashWord(word, length);
+        quint32 index = hash & mask;
+        bool duplicate = false;
+        for (; table[index].entry; index = (index + 1) & mask) {
+            const CompiledDictionary::Entry &entry = entries[table[index].entry - 1];
+            if (table[index].hash == hash && entry.length == length &&
+                0 == memcmp(pool.constData() + entry.offset, word, length * sizeof(QChar)))
+            {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            continue;
+        }
+        CompiledDictionary::Entry entry;
+        entry.offset = pool.size();
+        entry.length = length;
+        entries.push_back(entry);
+        table[index].hash = hash;
+        table[index].entry = entries.size();
+        for (quint32 c = 0; c < length; ++c) {
+            pool.push_back(word[c]);
+            ++frequency[word[c].unicode()];
+        }
+    }
+
+    QMultiMap<int, ushort> byFrequency;
+    for (QHash<ushort, int>::const_iterator it = frequency.constBegin(); it != frequency.constEnd(); ++it) {
+        byFrequency.insert(-it.value(), it.key());
+    }
+    QVector<QChar> alphabet;
+    foreach (ushort c, byFrequency) {
+        alphabet.push_back(QChar(c));
+    }
+
+    CompiledDictionary::Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.sourceSize = source.size();
+    header.sourceModified = source.lastModified().toTime_t();
+    header.wordCount = entries.size();
+    header.tableSize = tableSize;
+    header.alphabetLength = alphabet.size();
+    header.poolLength = pool.size();
+
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QString temporaryName = fileName + ".tmp";
+    QFile file(temporaryName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Cannot write dictionary cache" << temporaryName << file.errorString();
+        return false;
+    }
+    bool ok = file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header) &&
+            file.write(reinterpret_cast<const char*>(table.constData()),
+                       table.size() * sizeof(CompiledDictionary::Slot)) ==
+                static_cast<qint64>(table.size() * sizeof(CompiledDictionary::Slot)) &&
+            file.write(reinterpret_cast<const char*>(entries.constData()),
+                       entries.size() * sizeof(CompiledDictionary::Entry)) ==
+                static_cast<qint64>(entries.size() * sizeof(CompiledDictionary::Entry)) &&
+            file.write(reinterpret_cast<const char*>(alphabet.constData()),
+                       alphabet.size() * sizeof(QChar)) ==
+                static_cast<qint64>(alphabet.size() * sizeof(QChar)) &&
+            file.write(reinterpret_cast<const char*>(pool.constData()),
+                       pool.size() * sizeof(QChar)) ==
+                static_cast<qint64>(pool.size() * sizeof(QChar));
+    file.close();
+    if (!ok) {
+        qDebug() << "Cannot write dictionary cache" << temporaryName << file.errorString();
+        QFile::remove(temporaryName);
+        return false;
+    }
+    QFile::remove(fileName);
+    if (!QFile::rename(temporaryName, fileName)) {
+        qDebug() << "Cannot rename dictionary cache" << temporaryName;
+        QFile::remove(temporaryName);
+        return false;
+    }
+    qDebug() << "Compiled" << entries.size() << "words into" << fileName;
+    return true;
+}
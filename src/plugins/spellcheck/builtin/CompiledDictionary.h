@@ -0,0 +1,97 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_COMPILED_DICTIONARY_H
+#define BLACK_MILORD_COMPILED_DICTIONARY_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QChar>
+
+class QFileInfo;
+
+/**
+ * Read only word list compiled into a cache file and mapped into memory.
+ * Lookups hash the UTF-16 word in place and never allocate, so they are
+ * cheap enough to be called for every word of every highlighted block.
+ */
+class CompiledDictionary
+{
+public:
+    CompiledDictionary();
+    ~CompiledDictionary();
+
+    /**
+     * Maps cacheFileName, compiling it from sourceFileName first when the
+     * cache is missing, broken or older than the source.
+     */
+    bool load(const QString &sourceFileName, const QString &cacheFileName);
+    bool isLoaded() const;
+
+    bool contains(const QChar *word, int length) const;
+    bool contains(const QString &word) const;
+
+    /**
+     * Characters used by the dictionary words, most frequent first.
+     * Used to generate suggestion candidates.
+     */
+    const QChar* alphabet() const;
+    int alphabetLength() const;
+
+private:
+    struct Header;
+    struct Slot;
+    struct Entry;
+
+    bool open(const QString &cacheFileName, const QFileInfo &source);
+    void close();
+
+    QFile m_file;
+    const uchar *m_data;
+    const Header *m_header;
+    const Slot *m_table;
+    const Entry *m_entries;
+    const QChar *m_alphabet;
+    const QChar *m_pool;
+
+    friend class DictionaryBuilder;
+};
+
+/**
+ * Collects words and writes them in the format understood by
+ * CompiledDictionary. Duplicated words are stored once.
+ */
+class DictionaryBuilder
+{
+public:
+    DictionaryBuilder();
+
+    void addWord(const QString &word);
+    bool write(const QString &fileName, const QFileInfo &source) const;
+
+private:
+    QVector<QChar> m_pool;
+    QVector<quint32> m_offsets;
+    QVector<quint32> m_lengths;
+};
+
+#endif /* BLACK_MILORD_COMPILED_DICTIONARY_H */
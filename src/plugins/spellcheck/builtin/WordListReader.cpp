@@ -0,0 +1,332 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "WordListReader.h"
+#include "CompiledDictionary.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextCodec>
+#include <QRegExp>
+
+namespace {
+    //whitespace separated fields of a line, called for every line so no regular expression is used
+    QStringList splitFields(const QString &line, int maxFields = -1)
+    {
+        QStringList fields;
+        const int length = line.length();
+        int position = 0;
+        while (fields.size() != maxFields) {
+            while (position < length && line[position].isSpace()) {
+                ++position;
+            }
+            if (position == length) {
+                break;
+            }
+            const int start = position;
+            while (position < length && !line[position].isSpace()) {
+                ++position;
+            }
+            fields.append(line.mid(start, position - start));
+        }
+        return fields;
+    }
+}
+
+WordListReader::WordListReader() :
+    m_codec(QTextCodec::codecForName("UTF-8")),
+    m_flagMode(FlagChar)
+{
+}
+
+bool WordListReader::read(const QString &fileName, DictionaryBuilder &builder)
+{
+    WordListReader reader;
+    QFileInfo info(fileName);
+    if (0 == info.suffix().compare("dic", Qt::CaseInsensitive)) {
+        QString affixFile = info.dir().absoluteFilePath(info.completeBaseName() + ".aff");
+        if (QFile::exists(affixFile) && !reader.readAffixes(affixFile)) {
+            return false;
+        }
+        return reader.readHunspell(fileName, builder);
+    }
+    return reader.readPlain(fileName, builder);
+}
+
+bool WordListReader::readPlain(const QString &fileName, DictionaryBuilder &builder)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open word list" << fileName << file.errorString();
+        return false;
+    }
+    QStringList lines = m_codec->toUnicode(file.readAll()).split('\n');
+    foreach (const QString &line, lines) {
+        QString word = line.trimmed();
+        if (!word.isEmpty() && !word.startsWith('#')) {
+            builder.addWord(word);
+        }
+    }
+    return true;
+}
+
+bool WordListReader::readAffixes(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open affix file" << fileName << file.errorString();
+        return false;
+    }
+    QByteArray content = file.readAll();
+
+    // encoding has to be known before anything else is decoded
+    QRegExp setExpression("(^|\\n)SET\\s+(\\S+)");
+    if (-1 != setExpression.indexIn(QString::fromLatin1(content.constData(), content.size()))) {
+        QTextCodec *codec = QTextCodec::codecForName(setExpression.cap(2).toAscii());
+        if (codec) {
+            m_codec = codec;
+        }
+        else {
+            qDebug() << "Unknown dictionary encoding" << setExpression.cap(2);
+        }
+    }
+
+    bool aliasCountRead = false;
+    QStringList lines = m_codec->toUnicode(content).split('\n');
+    foreach (const QString &line, lines) {
+        QStringList fields = splitFields(line);
+        if (fields.isEmpty() || fields[0].startsWith('#')) {
+            continue;
+        }
+        const QString &keyword = fields[0];
+        if (keyword == "FLAG" && fields.size() > 1) {
+            if (fields[1] == "long") {
+                m_flagMode = FlagLong;
+            }
+            else if (fields[1] == "num") {
+                m_flagMode = FlagNumber;
+            }
+            else {
+                m_flagMode = FlagChar;
+            }
+        }
+        else if (keyword == "AF" && fields.size() > 1) {
+            // first AF line holds the number of aliases
+            if (aliasCountRead) {
+                m_aliases.push_back(fields[1]);
+            }
+            aliasCountRead = true;
+        }
+        else if (keyword == "FORBIDDENWORD" && fields.size() > 1) {
+            m_forbiddenFlag = fields[1];
+        }
+        else if (keyword == "NEEDAFFIX" && fields.size() > 1) {
+            m_needAffixFlag = fields[1];
+        }
+        else if (keyword == "ONLYINCOMPOUND" && fields.size() > 1) {
+            m_onlyInCompoundFlag = fields[1];
+        }
+        else if ((keyword == "PFX" || keyword == "SFX") && fields.size() >= 4) {
+            QHash<QString, AffixClass> &affixes = keyword == "PFX" ? m_prefixes : m_suffixes;
+            const QString &flag = fields[1];
+            if (!affixes.contains(flag)) {
+                AffixClass affixClass;
+                affixClass.crossProduct = fields[2] == "Y";
+                affixes.insert(flag, affixClass);
+                continue;
+            }
+            AffixRule rule;
+            rule.strip = fields[2] == "0" ? QString() : fields[2];
+            rule.append = fields[3].section('/', 0, 0);
+            if (rule.append == "0") {
+                rule.append.clear();
+            }
+            rule.condition = parseCondition(fields.size() > 4 ? fields[4] : QString("."));
+            affixes[flag].rules.push_back(rule);
+        }
+    }
+    return true;
+}
+
+bool WordListReader::readHunspell(const QString &fileName, DictionaryBuilder &builder)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open dictionary" << fileName << file.errorString();
+        return false;
+    }
+    QStringList lines = m_codec->toUnicode(file.readAll()).split('\n');
+    bool first = true;
+    foreach (const QString &line, lines) {
+        if (first) {
+            // word count
+            first = false;
+            bool isCount;
+            line.trimmed().toInt(&isCount);
+            if (isCount) {
+                continue;
+            }
+        }
+        const QStringList fields = splitFields(line, 1);
+        QString entry = fields.isEmpty() ? QString() : fields[0];
+        if (entry.isEmpty() || line.startsWith('\t')) {
+            continue;
+        }
+        int slash = entry.indexOf('/', 1);
+        if (-1 == slash) {
+            expand(entry, QString(), builder);
+        }
+        else {
+            expand(entry.left(slash), entry.mid(slash + 1), builder);
+        }
+    }
+    return true;
+}
+
+void WordListReader::expand(const QString &word, const QString &flags, DictionaryBuilder &builder) const
+{
+    QStringList flagList = parseFlags(flags);
+    if (flagList.contains(m_forbiddenFlag) || flagList.contains(m_onlyInCompoundFlag)) {
+        return;
+    }
+    if (!flagList.contains(m_needAffixFlag)) {
+        builder.addWord(word);
+    }
+
+    QStringList crossSuffixed;
+    foreach (const QString &flag, flagList) {
+        QHash<QString, AffixClass>::const_iterator affixClass = m_suffixes.find(flag);
+        if (affixClass == m_suffixes.end()) {
+            continue;
+        }
+        foreach (const AffixRule &rule, affixClass->rules) {
+            if (!word.endsWith(rule.strip) || !matches(rule.condition, word, true)) {
+                continue;
+            }
+            QString form = word.left(word.length() - rule.strip.length()) + rule.append;
+            builder.addWord(form);
+            if (affixClass->crossProduct) {
+                crossSuffixed.push_back(form);
+            }
+        }
+    }
+
+    foreach (const QString &flag, flagList) {
+        QHash<QString, AffixClass>::const_iterator affixClass = m_prefixes.find(flag);
+        if (affixClass == m_prefixes.end()) {
+            continue;
+        }
+        foreach (const AffixRule &rule, affixClass->rules) {
+            if (word.startsWith(rule.strip) && matches(rule.condition, word, false)) {
+                builder.addWord(rule.append + word.mid(rule.strip.length()));
+            }
+            if (!affixClass->crossProduct) {
+                continue;
+            }
+            foreach (const QString &form, crossSuffixed) {
+                if (form.startsWith(rule.strip) && matches(rule.condition, form, false)) {
+                    builder.addWord(rule.append + form.mid(rule.strip.length()));
+                }
+            }
+        }
+    }
+}
+
+QStringList WordListReader::parseFlags(const QString &flags) const
+{
+    QString expanded = flags;
+    if (!m_aliases.isEmpty()) {
+        bool ok;
+        int alias = flags.toInt(&ok);
+        if (ok && alias > 0 && alias <= m_aliases.size()) {
+            expanded = m_aliases[alias - 1];
+        }
+    }
+    QStringList result;
+    switch (m_flagMode) {
+    case FlagLong:
+        for (int i = 0; i + 1 < expanded.length(); i += 2) {
+            result.push_back(expanded.mid(i, 2));
+        }
+        break;
+    case FlagNumber:
+        result = expanded.split(',', QString::SkipEmptyParts);
+        break;
+    default:
+        for (int i = 0; i < expanded.length(); ++i) {
+            result.push_back(expanded.mid(i, 1));
+        }
+        break;
+    }
+    return result;
+}
+
+QVector<WordListReader::ConditionElement> WordListReader::parseCondition(const QString &condition)
+{
+    QVector<ConditionElement> result;
+    if (condition == ".") {
+        return result;
+    }
+    for (int i = 0; i < condition.length(); ++i) {
+        ConditionElement element;
+        element.any = false;
+        element.negated = false;
+        if (condition[i] == '.') {
+            element.any = true;
+        }
+        else if (condition[i] == '[') {
+            int end = condition.indexOf(']', i + 1);
+            if (-1 == end) {
+                end = condition.length();
+            }
+            element.characters = condition.mid(i + 1, end - i - 1);
+            if (element.characters.startsWith('^')) {
+                element.negated = true;
+                element.characters.remove(0, 1);
+            }
+            i = end;
+        }
+        else {
+            element.characters = condition[i];
+        }
+        result.push_back(element);
+    }
+    return result;
+}
+
+bool WordListReader::matches(const QVector<ConditionElement> &condition, const QString &word, bool suffix)
+{
+    if (word.length() < condition.size()) {
+        return false;
+    }
+    const int start = suffix ? word.length() - condition.size() : 0;
+    for (int i = 0; i < condition.size(); ++i) {
+        const ConditionElement &element = condition[i];
+        if (element.any) {
+            continue;
+        }
+        if (element.characters.contains(word[start + i]) == element.negated) {
+            return false;
+        }
+    }
+    return true;
+}
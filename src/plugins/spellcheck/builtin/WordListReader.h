@@ -0,0 +1,89 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_WORD_LIST_READER_H
+#define BLACK_MILORD_WORD_LIST_READER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+class QTextCodec;
+class DictionaryBuilder;
+
+/**
+ * Reads word lists into DictionaryBuilder.
+ * Files with .dic extension are read as Hunspell dictionaries and their
+ * prefix/suffix rules from the matching .aff file are expanded, every other
+ * file is read as UTF-8 text with one word per line.
+ */
+class WordListReader
+{
+public:
+    static bool read(const QString &fileName, DictionaryBuilder &builder);
+
+private:
+    enum FlagMode {
+        FlagChar,
+        FlagLong,
+        FlagNumber
+    };
+
+    struct ConditionElement {
+        bool any;
+        bool negated;
+        QString characters;
+    };
+
+    struct AffixRule {
+        QString strip;
+        QString append;
+        QVector<ConditionElement> condition;
+    };
+
+    struct AffixClass {
+        bool crossProduct;
+        QVector<AffixRule> rules;
+    };
+
+    WordListReader();
+
+    bool readPlain(const QString &fileName, DictionaryBuilder &builder);
+    bool readAffixes(const QString &fileName);
+    bool readHunspell(const QString &fileName, DictionaryBuilder &builder);
+    void expand(const QString &word, const QString &flags, DictionaryBuilder &builder) const;
+    QStringList parseFlags(const QString &flags) const;
+
+    static QVector<ConditionElement> parseCondition(const QString &condition);
+    static bool matches(const QVector<ConditionElement> &condition, const QString &word, bool suffix);
+
+    QTextCodec *m_codec;
+    FlagMode m_flagMode;
+    QStringList m_aliases;
+    QString m_forbiddenFlag;
+    QString m_needAffixFlag;
+    QString m_onlyInCompoundFlag;
+    QHash<QString, AffixClass> m_prefixes;
+    QHash<QString, AffixClass> m_suffixes;
+};
+
+#endif /* BLACK_MILORD_WORD_LIST_READER_H */
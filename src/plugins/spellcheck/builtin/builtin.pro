@@ -0,0 +1,12 @@
+TEMPLATE = lib
+CONFIG += plugin
+TARGET = spellcheck_builtin
+
+SOURCES += BuiltinSpellcheck.cpp
+SOURCES += CompiledDictionary.cpp
+SOURCES += WordListReader.cpp
+HEADERS += BuiltinSpellcheck.h
+HEADERS += CompiledDictionary.h
+HEADERS += WordListReader.h
+
+include(../../../../project.pri)
@@ -1,3 +1,4 @@
 TEMPLATE = subdirs
 CONFIG += ordered debug_and_release
-SUBDIRS += aspell
\ No newline at end of file
+SUBDIRS += aspell
+SUBDIRS += builtin
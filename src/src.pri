@@ -0,0 +1,95 @@
+#sources shared by the editor and the command line tool
+
+SOURCES += $$PWD/gui/Gui.cpp
+SOURCES += $$PWD/gui/MainWindow.cpp
+SOURCES += $$PWD/gui/StatusBar.cpp
+SOURCES += $$PWD/gui/PlainTextEditor.cpp
+SOURCES += $$PWD/gui/data/BlockData.cpp
+SOURCES += $$PWD/gui/data/XMLElement.cpp
+SOURCES += $$PWD/book/Book.cpp
+SOURCES += $$PWD/book/BookPicture.cpp
+SOURCES += $$PWD/book/PieceTable.cpp
+SOURCES += $$PWD/book/TextStatistics.cpp
+SOURCES += $$PWD/book/ElementIndex.cpp
+SOURCES += $$PWD/book/AbstractBook.cpp
+SOURCES += $$PWD/book/BackupManager.cpp
+SOURCES += $$PWD/book/MetadataScanner.cpp
+SOURCES += $$PWD/book/mobi/MobiFile.cpp
+SOURCES += $$PWD/book/mobi/DatabaseRecordInfoEntry.cpp
+SOURCES += $$PWD/book/mobi/DatabaseHeader.cpp
+SOURCES += $$PWD/book/mobi/PalmDOCHeader.cpp
+SOURCES += $$PWD/book/mobi/MOBIHeader.cpp
+SOURCES += $$PWD/book/mobi/EXTHHeader.cpp
+SOURCES += $$PWD/book/mobi/EXTHHeaderEntry.cpp
+SOURCES += $$PWD/book/mobi/MobiCodec.cpp
+SOURCES += $$PWD/book/mobi/TextRecordWriter.cpp
+SOURCES += $$PWD/utils/Formatting.cpp
+SOURCES += $$PWD/utils/TextSearch.cpp
+SOURCES += $$PWD/utils/WorkerThread.cpp
+SOURCES += $$PWD/utils/FindAllThread.cpp
+SOURCES += $$PWD/utils/ThumbnailThread.cpp
+SOURCES += $$PWD/utils/ImageOptimizer.cpp
+SOURCES += $$PWD/dialogs/HowToUseAspellWindow.cpp
+SOURCES += $$PWD/dialogs/SpellCheckingWindow.cpp
+SOURCES += $$PWD/dialogs/FindReplaceWindow.cpp
+SOURCES += $$PWD/dialogs/MetaDataWindow.cpp
+SOURCES += $$PWD/dialogs/AboutWindow.cpp
+SOURCES += $$PWD/dialogs/PictureViewerWindow.cpp
+SOURCES += $$PWD/options/OptionsWindow.cpp
+SOURCES += $$PWD/options/EditorPage.cpp
+SOURCES += $$PWD/options/MainPage.cpp
+SOURCES += $$PWD/options/HighlighterPage.cpp
+SOURCES += $$PWD/highlighter/HighlighterManager.cpp
+SOURCES += $$PWD/highlighter/HighlighterThread.cpp
+SOURCES += $$PWD/highlighter/HighlightersApplySettingsEvent.cpp
+SOURCES += $$PWD/highlighter/HighlightBlockEvent.cpp
+SOURCES += $$PWD/highlighter/HighlightBlockEventResponse.cpp
+
+HEADERS += $$PWD/gui/Gui.h
+HEADERS += $$PWD/gui/MainWindow.h
+HEADERS += $$PWD/gui/StatusBar.h
+HEADERS += $$PWD/gui/PlainTextEditor.h
+HEADERS += $$PWD/gui/data/BlockData.h
+HEADERS += $$PWD/gui/data/XMLElement.h
+HEADERS += $$PWD/book/Book.h
+HEADERS += $$PWD/book/BookPicture.h
+HEADERS += $$PWD/book/PieceTable.h
+HEADERS += $$PWD/book/TextStatistics.h
+HEADERS += $$PWD/book/ElementIndex.h
+HEADERS += $$PWD/book/AbstractBook.h
+HEADERS += $$PWD/book/BackupManager.h
+HEADERS += $$PWD/book/MetadataEnum.h
+HEADERS += $$PWD/book/BookMetadata.h
+HEADERS += $$PWD/book/MetadataScanner.h
+HEADERS += $$PWD/book/mobi/MobiFile.h
+HEADERS += $$PWD/book/mobi/HeaderLayout.h
+HEADERS += $$PWD/book/mobi/DatabaseRecordInfoEntry.h
+HEADERS += $$PWD/book/mobi/DatabaseHeader.h
+HEADERS += $$PWD/book/mobi/PalmDOCHeader.h
+HEADERS += $$PWD/book/mobi/MOBIHeader.h
+HEADERS += $$PWD/book/mobi/EXTHHeader.h
+HEADERS += $$PWD/book/mobi/EXTHHeaderEntry.h
+HEADERS += $$PWD/book/mobi/MobiCodec.h
+HEADERS += $$PWD/book/mobi/TextRecordWriter.h
+HEADERS += $$PWD/utils/Formatting.h
+HEADERS += $$PWD/utils/TextSearch.h
+HEADERS += $$PWD/utils/WorkerThread.h
+HEADERS += $$PWD/utils/FindAllThread.h
+HEADERS += $$PWD/utils/ThumbnailThread.h
+HEADERS += $$PWD/utils/ImageOptimizer.h
+HEADERS += $$PWD/dialogs/HowToUseAspellWindow.h
+HEADERS += $$PWD/dialogs/SpellCheckingWindow.h
+HEADERS += $$PWD/dialogs/FindReplaceWindow.h
+HEADERS += $$PWD/dialogs/MetaDataWindow.h
+HEADERS += $$PWD/dialogs/AboutWindow.h
+HEADERS += $$PWD/dialogs/PictureViewerWindow.h
+HEADERS += $$PWD/options/OptionsWindow.h
+HEADERS += $$PWD/options/EditorPage.h
+HEADERS += $$PWD/options/MainPage.h
+HEADERS += $$PWD/options/HighlighterPage.h
+HEADERS += $$PWD/options/IPageWidget.h
+HEADERS += $$PWD/highlighter/HighlighterManager.h
+HEADERS += $$PWD/highlighter/HighlighterThread.h
+HEADERS += $$PWD/highlighter/HighlightersApplySettingsEvent.h
+HEADERS += $$PWD/highlighter/HighlightBlockEvent.h
+HEADERS += $$PWD/highlighter/HighlightBlockEventResponse.h
@@ -0,0 +1,138 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "FindAllThread.h"
+#include <QDebug>
+
+#include "TextSearch.h"
+
+namespace {
+    //first results are posted soon, later ones in bigger parts
+    const int FIRST_BATCH_SIZE = 50;
+    const int BATCH_SIZE = 500;
+    //characters shown around the match
+    const int SNIPPET_CONTEXT = 30;
+}
+
+QEvent::Type FindAllResultEvent::m_type =
+    static_cast<QEvent::Type>(QEvent::registerEventType());
+
+FindAllResultEvent::FindAllResultEvent(int generation, const QVector<FindAllMatch> &matches, bool finished) :
+    QEvent(m_type),
+    m_generation(generation),
+    m_matches(matches),
+    m_finished(finished)
+{
+}
+
+FindAllResultEvent::~FindAllResultEvent()
+{
+}
+
+int FindAllResultEvent::getGeneration() const
+{
+    return m_generation;
+}
+
+const QVector<FindAllMatch>& FindAllResultEvent::getMatches() const
+{
+    return m_matches;
+}
+
+bool FindAllResultEvent::isFinished() const
+{
+    return m_finished;
+}
+
+FindAllThread::FindAllThread(QObject *receiver, int generation, const PieceTable &text,
+    const QString &pattern, int options) :
+    WorkerThread(receiver),
+    m_generation(generation),
+    m_text(text),
+    m_pattern(pattern),
+    m_options(options)
+{
+}
+
+FindAllThread::~FindAllThread()
+{
+}
+
+void FindAllThread::run()
+{
+    //regular expressions search the joined text, join it only once
+    if (m_options & TextSearch::OPTION_REGEXP) {
+        m_text.compact();
+    }
+    TextSearch search;
+    search.setPattern(m_pattern, m_options);
+
+    QVector<FindAllMatch> matches;
+    int batchSize = FIRST_BATCH_SIZE;
+    int found = 0;
+    int line = 0;
+    int nextNewLine = m_text.indexOf('\n');
+    int length = 0;
+    int position = search.indexIn(m_text, 0, length);
+    while (position != -1 && found < MAX_MATCHES && !isCanceled()) {
+        //empty matches can not be shown
+        if (length > 0) {
+            while (nextNewLine != -1 && nextNewLine < position) {
+                ++line;
+                nextNewLine = m_text.indexOf('\n', nextNewLine + 1);
+            }
+
+            FindAllMatch match;
+            match.position = position;
+            match.length = length;
+            match.line = line;
+            match.snippet = snippet(position, length);
+            matches.append(match);
+            ++found;
+            if (matches.size() >= batchSize) {
+                post(new FindAllResultEvent(m_generation, matches, false));
+                matches.clear();
+                batchSize = BATCH_SIZE;
+            }
+        }
+        position = search.indexIn(m_text, position + qMax(length, 1), length);
+    }
+    post(new FindAllResultEvent(m_generation, matches, true));
+}
+
+QString FindAllThread::snippet(int position, int length) const
+{
+    //context is cut at line breaks
+    const int start = qMax(position - SNIPPET_CONTEXT, 0);
+    QString before = m_text.mid(start, position - start);
+    before.remove(0, before.lastIndexOf('\n') + 1);
+    QString after = m_text.mid(position + length,
+        qMin(SNIPPET_CONTEXT, m_text.length() - position - length));
+    const int lineEnd = after.indexOf('\n');
+    if (lineEnd != -1) {
+        after.truncate(lineEnd);
+    }
+    //matches of regular expressions may span several lines
+    QString result = before + m_text.mid(position, length) + after;
+    result.replace('\n', ' ');
+    result.replace('\t', ' ');
+    return result;
+}
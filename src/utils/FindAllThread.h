@@ -0,0 +1,89 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_FIND_ALL_THREAD_H
+#define BLACK_MILORD_FIND_ALL_THREAD_H
+
+#include <QEvent>
+#include <QString>
+#include <QVector>
+#include <PieceTable.h>
+
+#include "WorkerThread.h"
+
+struct FindAllMatch {
+    int position;
+    int length;
+    //zero based number of the line
+    int line;
+    //the match with some surrounding text from the same line
+    QString snippet;
+};
+
+/**
+ * Part of the results posted by FindAllThread.
+ */
+class FindAllResultEvent :
+    public QEvent
+{
+public:
+    FindAllResultEvent(int generation, const QVector<FindAllMatch> &matches, bool finished);
+    virtual ~FindAllResultEvent();
+    int getGeneration() const;
+    const QVector<FindAllMatch>& getMatches() const;
+    //set for the last event of the search
+    bool isFinished() const;
+    static QEvent::Type getType() { return m_type; }
+private:
+    int m_generation;
+    QVector<FindAllMatch> m_matches;
+    bool m_finished;
+protected:
+    static QEvent::Type m_type;
+};
+
+/**
+ * Finds all matches of a pattern in a snapshot of the text.
+ * Results are posted to the receiver in parts as FindAllResultEvent
+ * tagged with the generation, so results of canceled searches can be told apart.
+ */
+class FindAllThread :
+    public WorkerThread
+{
+    Q_OBJECT
+public:
+    static const int MAX_MATCHES = 10000;
+
+    FindAllThread(QObject *receiver, int generation, const PieceTable &text,
+        const QString &pattern, int options);
+    virtual ~FindAllThread();
+protected:
+    void run();
+private:
+    QString snippet(int position, int length) const;
+
+    int m_generation;
+    PieceTable m_text;
+    QString m_pattern;
+    int m_options;
+};
+
+#endif /* BLACK_MILORD_FIND_ALL_THREAD_H */
@@ -21,30 +21,323 @@
 
 #include "Formatting.h"
 #include <QString>
-#include <QRegExp>
+
+namespace {
+    struct BlockTag {
+        const char *tag;
+        const char *replacement;
+    };
+
+    //tags separated by line breaks, compared case insensitive
+    const BlockTag BLOCK_TAGS[] = {
+        { "</h1>", "</h1>\n" },
+        { "</h2>", "</h2>\n" },
+        { "</h3>", "</h3>\n" },
+        { "</h4>", "</h4>\n" },
+        { "</h5>", "</h5>\n" },
+        { "</p>", "</p>\n" },
+        { "<p>", "\n<p>" },
+        { "<br/>", "<br/>\n" },
+        { "<html>", "<html>\n" },
+        { "<body>", "<body>\n" },
+        { "</body>", "</body>\n" },
+        { "<head>", "<head>\n" },
+        { "</head>", "</head>\n" }
+    };
+    const int BLOCK_TAGS_COUNT = sizeof(BLOCK_TAGS) / sizeof(BLOCK_TAGS[0]);
+
+    enum Match {
+        MATCH_NONE,
+        MATCH_PARTIAL,
+        MATCH_FULL
+    };
+
+    /**
+     * Single pass over the text, every character goes through a chain of steps
+     * and only the last one writes to the result:
+     * 1. line breaks are removed,
+     * 2. runs of spaces are collapsed to one space,
+     * 3. white spaces between tags are removed,
+     * 4. <br>, <br/> and <br /> with surrounding white spaces become <br/>,
+     * 5. line breaks are added around block tags,
+     * 6. pairs of line breaks are joined.
+     * Steps which need to look ahead keep the undecided characters in small buffers.
+     */
+    class HtmlNormalizer
+    {
+    public:
+        explicit HtmlNormalizer(int size) :
+            m_lastSpace(false),
+            m_afterTag(false),
+            m_skipBreakSpaces(false),
+            m_pendingLineBreak(false)
+        {
+            //block tags add some line breaks, removed line breaks usually leave more room
+            m_result.reserve(size + size / 16);
+        }
+
+        void append(QChar c)
+        {
+            if (c != '\n' && c != '\r') {
+                collapseSpaces(c);
+            }
+        }
+
+        QString finish()
+        {
+            if (!m_tagSpaces.isEmpty()) {
+                flushTagSpaces();
+            }
+            while (!m_breakCandidate.isEmpty()) {
+                rejectBreakCandidate();
+            }
+            if (!m_breakSpaces.isEmpty()) {
+                flushBreakSpaces();
+            }
+            while (!m_blockCandidate.isEmpty()) {
+                rejectBlockCandidate();
+            }
+            if (m_pendingLineBreak) {
+                m_result.append('\n');
+                m_pendingLineBreak = false;
+            }
+            return m_result;
+        }
+
+    private:
+        QString m_result;
+        bool m_lastSpace;
+        bool m_afterTag;
+        QString m_tagSpaces;
+        QString m_breakSpaces;
+        QString m_breakCandidate;
+        bool m_skipBreakSpaces;
+        QString m_blockCandidate;
+        bool m_pendingLineBreak;
+
+        //step 2
+        void collapseSpaces(QChar c)
+        {
+            const bool space = (c == ' ');
+            if (!space || !m_lastSpace) {
+                joinTags(c);
+            }
+            m_lastSpace = space;
+        }
+
+        //step 3
+        void joinTags(QChar c)
+        {
+            if (m_afterTag && c.isSpace()) {
+                m_tagSpaces.append(c);
+                return;
+            }
+            if (c == '<') {
+                m_tagSpaces.clear();
+            }
+            else if (!m_tagSpaces.isEmpty()) {
+                flushTagSpaces();
+            }
+            m_afterTag = (c == '>');
+            canonicalizeBreaks(c);
+        }
+
+        void flushTagSpaces()
+        {
+            for (int i = 0; i < m_tagSpaces.length(); ++i) {
+                canonicalizeBreaks(m_tagSpaces[i]);
+            }
+            m_tagSpaces.clear();
+        }
+
+        //step 4
+        void canonicalizeBreaks(QChar c)
+        {
+            if (!m_breakCandidate.isEmpty()) {
+                m_breakCandidate.append(c);
+                Match match = matchBreak(m_breakCandidate);
+                if (MATCH_FULL == match) {
+                    m_breakSpaces.clear();
+                    m_breakCandidate.clear();
+                    breakBlocks('<');
+                    breakBlocks('b');
+                    breakBlocks('r');
+                    breakBlocks('/');
+                    breakBlocks('>');
+                    m_skipBreakSpaces = true;
+                }
+                else if (MATCH_NONE == match) {
+                    rejectBreakCandidate();
+                }
+                return;
+            }
+            if (c.isSpace()) {
+                if (!m_skipBreakSpaces) {
+                    m_breakSpaces.append(c);
+                }
+                return;
+            }
+            m_skipBreakSpaces = false;
+            if (c == '<') {
+                m_breakCandidate.append(c);
+                return;
+            }
+            if (!m_breakSpaces.isEmpty()) {
+                flushBreakSpaces();
+            }
+            breakBlocks(c);
+        }
+
+        void rejectBreakCandidate()
+        {
+            //no match starts at this '<', following characters may start another one
+            const QString rest = m_breakCandidate;
+            m_breakCandidate.clear();
+            if (!m_breakSpaces.isEmpty()) {
+                flushBreakSpaces();
+            }
+            breakBlocks(rest[0]);
+            for (int i = 1; i < rest.length(); ++i) {
+                canonicalizeBreaks(rest[i]);
+            }
+        }
+
+        void flushBreakSpaces()
+        {
+            for (int i = 0; i < m_breakSpaces.length(); ++i) {
+                breakBlocks(m_breakSpaces[i]);
+            }
+            m_breakSpaces.clear();
+        }
+
+        static Match matchBreak(const QString &candidate)
+        {
+            const char prefix[] = "<br";
+            const int length = candidate.length();
+            int i = 0;
+            for (; i < 3; ++i) {
+                if (i == length) {
+                    return MATCH_PARTIAL;
+                }
+                if (candidate[i] != prefix[i]) {
+                    return MATCH_NONE;
+                }
+            }
+            while (i < length && candidate[i].isSpace()) {
+                ++i;
+            }
+            if (i < length && candidate[i] == '/') {
+                ++i;
+            }
+            if (i == length) {
+                return MATCH_PARTIAL;
+            }
+            return (candidate[i] == '>' && i == length - 1) ? MATCH_FULL : MATCH_NONE;
+        }
+
+        //step 5
+        void breakBlocks(QChar c)
+        {
+            if (m_blockCandidate.isEmpty() && c != '<') {
+                collapseLineBreaks(c);
+                return;
+            }
+            m_blockCandidate.append(c);
+            int tag = -1;
+            Match match = matchBlockTag(m_blockCandidate, tag);
+            if (MATCH_FULL == match) {
+                m_blockCandidate.clear();
+                for (const char *replacement = BLOCK_TAGS[tag].replacement; *replacement; ++replacement) {
+                    collapseLineBreaks(*replacement);
+                }
+            }
+            else if (MATCH_NONE == match) {
+                rejectBlockCandidate();
+            }
+        }
+
+        void rejectBlockCandidate()
+        {
+            const QString rest = m_blockCandidate;
+            m_blockCandidate.clear();
+            collapseLineBreaks(rest[0]);
+            for (int i = 1; i < rest.length(); ++i) {
+                breakBlocks(rest[i]);
+            }
+        }
+
+        static Match matchBlockTag(const QString &candidate, int &tag)
+        {
+            Match result = MATCH_NONE;
+            for (int i = 0; i < BLOCK_TAGS_COUNT; ++i) {
+                const char *pattern = BLOCK_TAGS[i].tag;
+                int j = 0;
+                while (j < candidate.length() && pattern[j] && candidate[j].toLower() == pattern[j]) {
+                    ++j;
+                }
+                if (j == candidate.length()) {
+                    if (!pattern[j]) {
+                        tag = i;
+                        return MATCH_FULL;
+                    }
+                    result = MATCH_PARTIAL;
+                }
+            }
+            return result;
+        }
+
+        //step 6
+        void collapseLineBreaks(QChar c)
+        {
+            if (c == '\n') {
+                if (m_pendingLineBreak) {
+                    m_result.append(c);
+                }
+                m_pendingLineBreak = !m_pendingLineBreak;
+                return;
+            }
+            if (m_pendingLineBreak) {
+                m_result.append('\n');
+                m_pendingLineBreak = false;
+            }
+            m_result.append(c);
+        }
+    };
+}
 
 QString Formatting::formatHTMLContent(const QString &text)
 {
     //uncomment for debugging and testing
     //return text;
-    return QString(text).\
-           remove("\n").
-           remove("\r").
-           replace(QRegExp("( ){2,}"), " ").
-           replace(QRegExp(">\\s+<"), "><").
-           replace(QRegExp("(\\s*<br\\s*/?>\\s*)"), "<br/>").
-           replace("</h1>", "</h1>\n", Qt::CaseInsensitive).
-           replace("</h2>", "</h2>\n", Qt::CaseInsensitive).
-           replace("</h3>", "</h3>\n", Qt::CaseInsensitive).
-           replace("</h4>", "</h4>\n", Qt::CaseInsensitive).
-           replace("</h5>", "</h5>\n", Qt::CaseInsensitive).
-           replace("</p>", "</p>\n", Qt::CaseInsensitive).
-           replace("<p>", "\n<p>", Qt::CaseInsensitive).
-           replace("<br/>", "<br/>\n", Qt::CaseInsensitive).
-           replace("<html>", "<html>\n", Qt::CaseInsensitive).
-           replace("<body>", "<body>\n", Qt::CaseInsensitive).
-           replace("</body>", "</body>\n", Qt::CaseInsensitive).
-           replace("<head>", "<head>\n", Qt::CaseInsensitive).
-           replace("</head>", "</head>\n", Qt::CaseInsensitive).
-           replace("\n\n", "\n");
+    HtmlNormalizer normalizer(text.length());
+    const QChar *data = text.constData();
+    const int length = text.length();
+    for (int i = 0; i < length; ++i) {
+        normalizer.append(data[i]);
+    }
+    return normalizer.finish();
+}
+
+QString Formatting::normalizeEditorText(const QString &text)
+{
+    QString result(text);
+    QChar *data = result.data();
+    const int length = result.length();
+    for (int i = 0; i < length; ++i) {
+        switch (data[i].unicode()) {
+        case '\r':
+        case QChar::ParagraphSeparator:
+        case QChar::LineSeparator:
+        case 0xfdd0:
+        case 0xfdd1:
+            data[i] = QChar('\n');
+            break;
+        case QChar::Nbsp:
+            data[i] = QChar(' ');
+            break;
+        default:
+            break;
+        }
+    }
+    return result;
 }
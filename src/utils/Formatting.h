@@ -28,6 +28,8 @@ class Formatting
 {
 public:
     static QString formatHTMLContent(const QString &text);
+    //Line breaks as '\n' and non breaking spaces as spaces, the way the editor returns text.
+    static QString normalizeEditorText(const QString &text);
 };
 
 #endif /* BLACK_MILORD_FORMATTING_H */
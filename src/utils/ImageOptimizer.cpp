@@ -0,0 +1,182 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "ImageOptimizer.h"
+#include <QDebug>
+#include <QImage>
+#include <QPainter>
+#include <QBuffer>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QVector>
+
+#include <BookPicture.h>
+
+namespace {
+    const int MIN_JPEG_QUALITY = 20;
+    const int MAX_JPEG_QUALITY = 90;
+    //factor used when even the lowest quality is too big
+    const qreal DOWNSCALE_FACTOR = 0.8;
+    const int MIN_DIMENSION = 16;
+
+    class OptimizeTask :
+        public QRunnable
+    {
+    public:
+        OptimizeTask(const ImageOptimizer &optimizer, const QByteArray &pictureData, QByteArray &result) :
+            m_optimizer(optimizer),
+            m_pictureData(pictureData),
+            m_result(result)
+        {
+        }
+
+        void run()
+        {
+            m_result = m_optimizer.optimize(m_pictureData);
+        }
+
+    private:
+        const ImageOptimizer &m_optimizer;
+        const QByteArray m_pictureData;
+        QByteArray &m_result;
+    };
+}
+
+ImageOptimizer::ImageOptimizer(const QSize &screenSize, int maxSize) :
+    m_screenSize(screenSize),
+    m_maxSize(maxSize),
+    m_compatibleOnly(false)
+{
+}
+
+void ImageOptimizer::setCompatibleFormatsOnly(bool compatibleOnly)
+{
+    m_compatibleOnly = compatibleOnly;
+}
+
+QByteArray ImageOptimizer::optimize(const QByteArray &pictureData) const
+{
+    const QByteArray format = BookPicture::detectFormat(pictureData);
+    QImage picture;
+    if (!picture.loadFromData(pictureData, format.isEmpty() ? NULL : format.constData())) {
+        qDebug() << "Cannot decode picture for optimization";
+        return pictureData;
+    }
+    const bool fitsScreen = picture.width() <= m_screenSize.width() && picture.height() <= m_screenSize.height();
+    const bool compatible = !m_compatibleOnly || format == "JPG" || format == "GIF";
+    if (pictureData.size() <= m_maxSize && (fitsScreen || format == "GIF") && compatible) {
+        return pictureData;
+    }
+    if (format == "PNG" && !m_compatibleOnly) {
+        const QImage scaled = scaleToScreen(picture);
+        const QByteArray palette = encodePalette(scaled);
+        if (!palette.isEmpty() && palette.size() <= m_maxSize) {
+            return palette;
+        }
+        const QByteArray jpeg = encodeJpeg(scaled);
+        return jpeg.isEmpty() ? pictureData : jpeg;
+    }
+    //encoder may be missing, e.g. without the image format plugins
+    const QByteArray result = optimize(picture);
+    return result.isEmpty() ? pictureData : result;
+}
+
+QByteArray ImageOptimizer::optimize(const QImage &picture) const
+{
+    return encodeJpeg(scaleToScreen(picture));
+}
+
+QList<QByteArray> ImageOptimizer::optimize(const QList<QByteArray> &pictures) const
+{
+    QVector<QByteArray> results(pictures.size());
+    QThreadPool pool;
+    for (int i = 0; i < pictures.size(); ++i) {
+        pool.start(new OptimizeTask(*this, pictures[i], results[i]));
+    }
+    pool.waitForDone();
+    return results.toList();
+}
+
+QByteArray ImageOptimizer::encode(const QImage &picture, const char *format, int quality) const
+{
+    QByteArray result;
+    QBuffer buffer(&result);
+    buffer.open(QIODevice::WriteOnly);
+    if (!picture.save(&buffer, format, quality)) {
+        return QByteArray();
+    }
+    return result;
+}
+
+QByteArray ImageOptimizer::encodePalette(const QImage &picture) const
+{
+    return encode(picture.convertToFormat(QImage::Format_Indexed8), "PNG", 100);
+}
+
+QByteArray ImageOptimizer::encodeJpeg(const QImage &picture) const
+{
+    //JPEG has no transparency, transparent parts become white
+    QImage image = picture;
+    if (image.hasAlphaChannel()) {
+        image = QImage(picture.size(), QImage::Format_RGB32);
+        image.fill(Qt::white);
+        QPainter painter(&image);
+        painter.drawImage(0, 0, picture);
+    }
+    while (true) {
+        QByteArray best = encode(image, "JPG", MIN_JPEG_QUALITY);
+        if (best.isEmpty()) {
+            qDebug() << "Cannot encode picture as JPEG";
+            return best;
+        }
+        if (best.size() <= m_maxSize) {
+            //highest quality which still fits
+            int low = MIN_JPEG_QUALITY + 1;
+            int high = MAX_JPEG_QUALITY;
+            while (low <= high) {
+                const int quality = (low + high) / 2;
+                const QByteArray encoded = encode(image, "JPG", quality);
+                if (encoded.size() <= m_maxSize) {
+                    best = encoded;
+                    low = quality + 1;
+                }
+                else {
+                    high = quality - 1;
+                }
+            }
+            return best;
+        }
+        const QSize size = image.size() * DOWNSCALE_FACTOR;
+        if (size.width() < MIN_DIMENSION || size.height() < MIN_DIMENSION) {
+            qDebug() << "Picture does not fit into" << m_maxSize << "bytes";
+            return best;
+        }
+        image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+}
+
+QImage ImageOptimizer::scaleToScreen(const QImage &picture) const
+{
+    if (picture.width() <= m_screenSize.width() && picture.height() <= m_screenSize.height()) {
+        return picture;
+    }
+    return picture.scaled(m_screenSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
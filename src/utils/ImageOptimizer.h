@@ -0,0 +1,74 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_IMAGE_OPTIMIZER_H
+#define BLACK_MILORD_IMAGE_OPTIMIZER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QSize>
+
+class QImage;
+
+/**
+ * Encodes pictures so they fit into a single Mobipocket image record.
+ * Pictures which already fit and are not larger than the device screen are kept as they are.
+ * Others are scaled down to the screen, PNG pictures are tried with a reduced palette
+ * and everything else is stored as JPEG with the best quality which still fits,
+ * found by binary search. Pictures are downscaled further only when the lowest quality is too big.
+ */
+class ImageOptimizer
+{
+public:
+    //largest image record accepted by Mobipocket readers
+    static const int MAX_PICTURE_SIZE = 63 * 1024;
+
+    explicit ImageOptimizer(const QSize &screenSize, int maxSize = MAX_PICTURE_SIZE);
+
+    /**
+     * Limits results to JPEG and GIF, which every Mobipocket reader displays.
+     * PNG and BMP pictures are then always stored as JPEG.
+     */
+    void setCompatibleFormatsOnly(bool compatibleOnly);
+
+    //original data is returned when the picture cannot be decoded or encoded
+    QByteArray optimize(const QByteArray &pictureData) const;
+    //empty when the picture cannot be encoded
+    QByteArray optimize(const QImage &picture) const;
+
+    /**
+     * Optimizes pictures in parallel, one task per picture.
+     * Blocks until all pictures are done.
+     */
+    QList<QByteArray> optimize(const QList<QByteArray> &pictures) const;
+
+private:
+    QByteArray encode(const QImage &picture, const char *format, int quality = -1) const;
+    QByteArray encodePalette(const QImage &picture) const;
+    QByteArray encodeJpeg(const QImage &picture) const;
+    QImage scaleToScreen(const QImage &picture) const;
+
+    QSize m_screenSize;
+    int m_maxSize;
+    bool m_compatibleOnly;
+};
+
+#endif /* BLACK_MILORD_IMAGE_OPTIMIZER_H */
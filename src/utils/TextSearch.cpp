@@ -0,0 +1,320 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "TextSearch.h"
+#include <QStringRef>
+#include <PieceTable.h>
+
+namespace {
+    //the same characters as \w of QRegExp
+    bool isWordCharacter(QChar c)
+    {
+        return c.isLetterOrNumber() || c.isMark() || c == '_';
+    }
+}
+
+TextSearch::TextSearch() :
+    m_options(OPTION_NONE)
+{
+}
+
+void TextSearch::setPattern(const QString &pattern, int options)
+{
+    if (pattern == m_pattern && options == m_options) {
+        return;
+    }
+    m_pattern = pattern;
+    m_options = options;
+    m_folded.clear();
+    m_skip.clear();
+    m_backwardSkip.clear();
+    m_regExp = QRegExp();
+
+    if (options & OPTION_REGEXP) {
+        QString expression = pattern;
+        if (options & OPTION_WORDS_ONLY) {
+            expression = "\\b" + expression + "\\b";
+        }
+        m_regExp = QRegExp(expression,
+                           (options & OPTION_CASE_SENSITIVE) ? Qt::CaseSensitive : Qt::CaseInsensitive);
+        m_regExp.setMinimal(true);
+        return;
+    }
+
+    const int length = pattern.length();
+    m_folded.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        m_folded.append(fold(pattern[i]));
+    }
+    //Horspool shifts for the last (forward) and the first (backward) character
+    //of the window, characters sharing low byte share the smallest shift
+    m_skip.fill(length, SKIP_TABLE_SIZE);
+    for (int i = 0; i < length - 1; ++i) {
+        m_skip[m_folded[i].unicode() % SKIP_TABLE_SIZE] = length - 1 - i;
+    }
+    m_backwardSkip.fill(length, SKIP_TABLE_SIZE);
+    for (int i = length - 1; i > 0; --i) {
+        m_backwardSkip[m_folded[i].unicode() % SKIP_TABLE_SIZE] = i;
+    }
+}
+
+QString TextSearch::pattern() const
+{
+    return m_pattern;
+}
+
+int TextSearch::options() const
+{
+    return m_options;
+}
+
+bool TextSearch::isValid() const
+{
+    if (m_options & OPTION_REGEXP) {
+        return !m_pattern.isEmpty() && m_regExp.isValid();
+    }
+    return !m_folded.isEmpty();
+}
+
+int TextSearch::indexIn(const PieceTable &text, int from, int &length) const
+{
+    length = 0;
+    if (!isValid()) {
+        return -1;
+    }
+    from = qMax(from, 0);
+    if (m_options & OPTION_REGEXP) {
+        int position = m_regExp.indexIn(text.toString(), from);
+        length = m_regExp.matchedLength();
+        return position;
+    }
+    int position = from;
+    while ((position = literalIndexIn(text, position)) != -1) {
+        if (!(m_options & OPTION_WORDS_ONLY) || isWordMatch(text, position)) {
+            length = m_folded.length();
+            return position;
+        }
+        ++position;
+    }
+    return -1;
+}
+
+int TextSearch::lastIndexIn(const PieceTable &text, int from, int &length) const
+{
+    length = 0;
+    if (!isValid() || from < 0) {
+        return -1;
+    }
+    if (m_options & OPTION_REGEXP) {
+        int position = m_regExp.lastIndexIn(text.toString(), from);
+        length = m_regExp.matchedLength();
+        return position;
+    }
+    int position = from;
+    while ((position = literalLastIndexIn(text, position)) != -1) {
+        if (!(m_options & OPTION_WORDS_ONLY) || isWordMatch(text, position)) {
+            length = m_folded.length();
+            return position;
+        }
+        --position;
+    }
+    return -1;
+}
+
+QVector<TextReplacement> TextSearch::replacements(const PieceTable &text, const QString &after) const
+{
+    QVector<TextReplacement> result;
+    if (!isValid()) {
+        return result;
+    }
+    TextReplacement replacement;
+    replacement.after = after;
+    if (m_options & OPTION_REGEXP) {
+        const QString string = text.toString();
+        int position = m_regExp.indexIn(string, 0);
+        while (position != -1) {
+            replacement.position = position;
+            replacement.length = m_regExp.matchedLength();
+            replacement.after = expandCaptures(after);
+            result.append(replacement);
+            //empty match would be found again at the same position
+            position = m_regExp.indexIn(string, position + qMax(replacement.length, 1));
+        }
+        return result;
+    }
+    int length = 0;
+    int position = indexIn(text, 0, length);
+    while (position != -1) {
+        replacement.position = position;
+        replacement.length = length;
+        result.append(replacement);
+        position = indexIn(text, position + length, length);
+    }
+    return result;
+}
+
+QString TextSearch::expandCaptures(const QString &after) const
+{
+    const int captures = m_regExp.captureCount();
+    if (captures == 0 || !after.contains('\\')) {
+        return after;
+    }
+    QString result;
+    result.reserve(after.length());
+    for (int i = 0; i < after.length(); ++i) {
+        if (after[i] == '\\' && i + 1 < after.length() && after[i + 1].isDigit()) {
+            int capture = after[i + 1].digitValue();
+            int digits = 1;
+            //two digits are used only if there are so many captures
+            if (i + 2 < after.length() && after[i + 2].isDigit() &&
+                capture * 10 + after[i + 2].digitValue() <= captures)
+            {
+                capture = capture * 10 + after[i + 2].digitValue();
+                digits = 2;
+            }
+            if (capture >= 1 && capture <= captures) {
+                result.append(m_regExp.cap(capture));
+                i += digits;
+                continue;
+            }
+        }
+        result.append(after[i]);
+    }
+    return result;
+}
+
+QChar TextSearch::fold(QChar c) const
+{
+    return (m_options & OPTION_CASE_SENSITIVE) ? c : c.toCaseFolded();
+}
+
+bool TextSearch::matchesAt(const QChar *text, int position) const
+{
+    const int length = m_folded.length();
+    for (int i = 0; i < length; ++i) {
+        if (fold(text[position + i]) != m_folded[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TextSearch::isWordMatch(const PieceTable &text, int position) const
+{
+    //the same as \bpattern\b
+    const int end = position + m_folded.length();
+    const bool before = position > 0 && isWordCharacter(text.at(position - 1));
+    const bool after = end < text.length() && isWordCharacter(text.at(end));
+    return before != isWordCharacter(text.at(position)) &&
+           after != isWordCharacter(text.at(end - 1));
+}
+
+int TextSearch::indexInBuffer(const QChar *text, int length, int from) const
+{
+    const int patternLength = m_folded.length();
+    const QChar last = m_folded[patternLength - 1];
+    int position = from;
+    while (position <= length - patternLength) {
+        const QChar c = fold(text[position + patternLength - 1]);
+        if (c == last && matchesAt(text, position)) {
+            return position;
+        }
+        position += m_skip[c.unicode() % SKIP_TABLE_SIZE];
+    }
+    return -1;
+}
+
+int TextSearch::lastIndexInBuffer(const QChar *text, int length, int from) const
+{
+    const int patternLength = m_folded.length();
+    const QChar first = m_folded[0];
+    int position = qMin(from, length - patternLength);
+    while (position >= 0) {
+        const QChar c = fold(text[position]);
+        if (c == first && matchesAt(text, position)) {
+            return position;
+        }
+        position -= m_backwardSkip[c.unicode() % SKIP_TABLE_SIZE];
+    }
+    return -1;
+}
+
+int TextSearch::literalIndexIn(const PieceTable &text, int from) const
+{
+    //matches inside a piece are searched in place, only matches crossing
+    //the end of a piece are searched in a copy of the few characters around it
+    const int patternLength = m_folded.length();
+    int offset = 0;
+    for (int i = 0; i < text.chunkCount(); ++i) {
+        const QStringRef chunk = text.chunk(i);
+        const int chunkEnd = offset + chunk.length();
+        if (chunkEnd > from) {
+            const int start = qMax(from, offset);
+            int position = indexInBuffer(chunk.unicode(), chunk.length(), start - offset);
+            if (position != -1) {
+                return offset + position;
+            }
+            const int crossStart = qMax(start, chunkEnd - patternLength + 1);
+            if (crossStart < chunkEnd && chunkEnd < text.length()) {
+                const QString window = text.mid(crossStart, chunkEnd - crossStart + patternLength - 1);
+                position = indexInBuffer(window.constData(), window.length(), 0);
+                if (position != -1 && crossStart + position < chunkEnd) {
+                    return crossStart + position;
+                }
+            }
+        }
+        offset = chunkEnd;
+    }
+    return -1;
+}
+
+int TextSearch::literalLastIndexIn(const PieceTable &text, int from) const
+{
+    const int patternLength = m_folded.length();
+    QVector<int> offsets(text.chunkCount());
+    int offset = 0;
+    for (int i = 0; i < offsets.size(); ++i) {
+        offsets[i] = offset;
+        offset += text.chunk(i).length();
+    }
+    for (int i = offsets.size() - 1; i >= 0; --i) {
+        if (offsets[i] > from) {
+            continue;
+        }
+        const QStringRef chunk = text.chunk(i);
+        const int chunkEnd = offsets[i] + chunk.length();
+        //matches crossing the end of the piece start later than the ones inside it
+        const int crossStart = qMax(offsets[i], chunkEnd - patternLength + 1);
+        const int crossEnd = qMin(from, chunkEnd - 1);
+        if (crossStart <= crossEnd && chunkEnd < text.length()) {
+            const QString window = text.mid(crossStart, crossEnd - crossStart + patternLength);
+            int position = lastIndexInBuffer(window.constData(), window.length(), crossEnd - crossStart);
+            if (position != -1) {
+                return crossStart + position;
+            }
+        }
+        int position = lastIndexInBuffer(chunk.unicode(), chunk.length(), from - offsets[i]);
+        if (position != -1) {
+            return offsets[i] + position;
+        }
+    }
+    return -1;
+}
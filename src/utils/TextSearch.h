@@ -0,0 +1,97 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_TEXT_SEARCH_H
+#define BLACK_MILORD_TEXT_SEARCH_H
+
+#include <QString>
+#include <QRegExp>
+#include <QVector>
+#include <Book.h>
+
+class PieceTable;
+
+/**
+ * Finds a pattern in the text without joining it into one string.
+ * Pattern is prepared once and reused until it or options change.
+ * Literal patterns are searched with Boyer-Moore-Horspool, regular
+ * expressions with QRegExp using minimal matching.
+ */
+class TextSearch
+{
+public:
+    enum Option {
+        OPTION_NONE = 0,
+        OPTION_REGEXP = 1,
+        OPTION_CASE_SENSITIVE = 2,
+        OPTION_WORDS_ONLY = 4
+    };
+
+    TextSearch();
+
+    void setPattern(const QString &pattern, int options);
+    QString pattern() const;
+    int options() const;
+    bool isValid() const;
+
+    /**
+     * Finds the first match starting at or after from.
+     * @param length set to the length of the match.
+     * @return position of the match or -1.
+     */
+    int indexIn(const PieceTable &text, int from, int &length) const;
+
+    /**
+     * Finds the last match starting at or before from.
+     */
+    int lastIndexIn(const PieceTable &text, int from, int &length) const;
+
+    /**
+     * All matches in the text, each one with its replacement.
+     * For regular expressions \1 to \99 in after are replaced with captured texts.
+     * Joined text is prepared only once for all matches.
+     */
+    QVector<TextReplacement> replacements(const PieceTable &text, const QString &after) const;
+
+private:
+    static const int SKIP_TABLE_SIZE = 256;
+
+    QString expandCaptures(const QString &after) const;
+    QChar fold(QChar c) const;
+    bool matchesAt(const QChar *text, int position) const;
+    bool isWordMatch(const PieceTable &text, int position) const;
+
+    int indexInBuffer(const QChar *text, int length, int from) const;
+    int lastIndexInBuffer(const QChar *text, int length, int from) const;
+    int literalIndexIn(const PieceTable &text, int from) const;
+    int literalLastIndexIn(const PieceTable &text, int from) const;
+
+    QString m_pattern;
+    int m_options;
+    //literal search
+    QString m_folded;
+    QVector<int> m_skip;
+    QVector<int> m_backwardSkip;
+    //regular expression search
+    mutable QRegExp m_regExp;
+};
+
+#endif /* BLACK_MILORD_TEXT_SEARCH_H */
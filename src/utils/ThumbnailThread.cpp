@@ -0,0 +1,95 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "ThumbnailThread.h"
+#include <QDebug>
+#include <QBuffer>
+#include <QImageReader>
+
+#include <BookPicture.h>
+
+QEvent::Type ThumbnailEvent::m_type =
+    static_cast<QEvent::Type>(QEvent::registerEventType());
+
+ThumbnailEvent::ThumbnailEvent(int generation, int index, const QImage &thumbnail) :
+    QEvent(m_type),
+    m_generation(generation),
+    m_index(index),
+    m_thumbnail(thumbnail)
+{
+}
+
+ThumbnailEvent::~ThumbnailEvent()
+{
+}
+
+int ThumbnailEvent::getGeneration() const
+{
+    return m_generation;
+}
+
+int ThumbnailEvent::getIndex() const
+{
+    return m_index;
+}
+
+QImage ThumbnailEvent::getThumbnail() const
+{
+    return m_thumbnail;
+}
+
+ThumbnailThread::ThumbnailThread(QObject *receiver, int generation, const QList<QByteArray> &pictures, const QSize &size) :
+    WorkerThread(receiver),
+    m_generation(generation),
+    m_pictures(pictures),
+    m_size(size)
+{
+}
+
+ThumbnailThread::~ThumbnailThread()
+{
+}
+
+void ThumbnailThread::run()
+{
+    for (int i = 0; i < m_pictures.size() && !isCanceled(); ++i) {
+        post(new ThumbnailEvent(m_generation, i, thumbnail(m_pictures[i])));
+    }
+}
+
+QImage ThumbnailThread::thumbnail(const QByteArray &pictureData) const
+{
+    QBuffer buffer;
+    buffer.setData(pictureData);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, BookPicture::detectFormat(pictureData));
+    //JPEG reader decodes directly at the reduced size
+    QSize size = reader.size();
+    if (size.isValid() && (size.width() > m_size.width() || size.height() > m_size.height())) {
+        size.scale(m_size, Qt::KeepAspectRatio);
+        reader.setScaledSize(size.expandedTo(QSize(1, 1)));
+    }
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qDebug() << "Cannot decode picture" << reader.errorString();
+    }
+    return image;
+}
@@ -0,0 +1,77 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_THUMBNAIL_THREAD_H
+#define BLACK_MILORD_THUMBNAIL_THREAD_H
+
+#include <QEvent>
+#include <QImage>
+#include <QByteArray>
+#include <QList>
+#include <QSize>
+
+#include "WorkerThread.h"
+
+/**
+ * Thumbnail of a single picture posted by ThumbnailThread.
+ */
+class ThumbnailEvent :
+    public QEvent
+{
+public:
+    ThumbnailEvent(int generation, int index, const QImage &thumbnail);
+    virtual ~ThumbnailEvent();
+    int getGeneration() const;
+    int getIndex() const;
+    //null image when the picture cannot be decoded
+    QImage getThumbnail() const;
+    static QEvent::Type getType() { return m_type; }
+private:
+    int m_generation;
+    int m_index;
+    QImage m_thumbnail;
+protected:
+    static QEvent::Type m_type;
+};
+
+/**
+ * Decodes pictures scaled down to thumbnails, in order.
+ * QImage is used as QPixmap can be created only in the GUI thread.
+ * Every thumbnail is posted to the receiver as ThumbnailEvent tagged with the generation.
+ */
+class ThumbnailThread :
+    public WorkerThread
+{
+    Q_OBJECT
+public:
+    ThumbnailThread(QObject *receiver, int generation, const QList<QByteArray> &pictures, const QSize &size);
+    virtual ~ThumbnailThread();
+protected:
+    void run();
+private:
+    QImage thumbnail(const QByteArray &pictureData) const;
+
+    int m_generation;
+    QList<QByteArray> m_pictures;
+    QSize m_size;
+};
+
+#endif /* BLACK_MILORD_THUMBNAIL_THREAD_H */
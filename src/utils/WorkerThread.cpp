@@ -0,0 +1,61 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#include "WorkerThread.h"
+#include <QDebug>
+#include <QApplication>
+#include <QMutexLocker>
+
+WorkerThread::WorkerThread(QObject *receiver) :
+    QThread(NULL),
+    m_receiver(receiver),
+    m_canceled(0)
+{
+    Q_ASSERT(receiver != NULL);
+    connect(this, SIGNAL(finished()), this, SLOT(deleteLater()));
+}
+
+WorkerThread::~WorkerThread()
+{
+}
+
+void WorkerThread::cancel()
+{
+    m_canceled = 1;
+    QMutexLocker locker(&m_mutex);
+    m_receiver = NULL;
+}
+
+bool WorkerThread::isCanceled() const
+{
+    return m_canceled != 0;
+}
+
+void WorkerThread::post(QEvent *event)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_receiver) {
+        QApplication::postEvent(m_receiver, event);
+    }
+    else {
+        delete event;
+    }
+}
@@ -0,0 +1,55 @@
+/************************************************************************
+ *                                                                      *
+ * Author: Lukasz Marek <lukasz.m.luki@gmail.com>                       *
+ *                                                                      *
+ * This file is part of BlackMilord.                                    *
+ *                                                                      *
+ * BlackMilord is free software: you can redistribute it and/or modify  *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * BlackMilord is distributed in the hope that it will be useful,       *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the         *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with BlackMilord. If not, see http://www.gnu.org/licenses/     *
+ *                                                                      *
+ ************************************************************************/
+
+#ifndef BLACK_MILORD_WORKER_THREAD_H
+#define BLACK_MILORD_WORKER_THREAD_H
+
+#include <QThread>
+#include <QEvent>
+#include <QMutex>
+
+/**
+ * Base of the threads posting their results to a receiver as events.
+ * Canceling detaches the receiver under a lock, so once cancel() returns
+ * no more events are posted and the receiver can be destroyed
+ * without waiting for the thread.
+ * The thread deletes itself when finished.
+ */
+class WorkerThread :
+    public QThread
+{
+    Q_OBJECT
+public:
+    explicit WorkerThread(QObject *receiver);
+    virtual ~WorkerThread();
+    //called from the receiver's thread, the work stops at the next check
+    void cancel();
+protected:
+    bool isCanceled() const;
+    //takes ownership of the event, it is deleted when the thread is canceled
+    void post(QEvent *event);
+private:
+    QMutex m_mutex;
+    QObject *m_receiver;
+    QAtomicInt m_canceled;
+};
+
+#endif /* BLACK_MILORD_WORKER_THREAD_H */